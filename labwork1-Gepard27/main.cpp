@@ -2,14 +2,412 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <ctime>
+#include <queue>
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <deque>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <unordered_map>
+#include <set>
+#include <bit>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <stdlib.h>
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 
 
+enum class Log_field { Skip, Remote_addr, Local_time, Request, Status, Bytes_send, Referer, User_agent };
+
+struct Log_record {
+    std::string_view remote_addr;
+    std::string_view local_time;
+    std::string_view request;
+    std::string_view status;
+    std::string_view bytes_send;
+    std::string_view referer;
+    std::string_view user_agent;
+};
+
+const char kCommonFormat[] = "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent";
+const char kCombinedFormat[] =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent \"$http_referer\" \"$http_user_agent\"";
+
+// An nginx log_format or Apache LogFormat string compiled once into steps: each step skips its
+// literal and takes a field up to the literal of the next step, or up to the end of the line.
+// In the common format the request runs up to the last quote of the line, as it always has,
+// so that a request containing a quote is still read whole.
+struct Log_format {
+    struct Step {
+        std::string literal;
+        Log_field field = Log_field::Skip;
+        bool has_field = false;
+        bool up_to_last = false;
+    };
+
+    std::vector<Step> steps;
+
+    // False if the format is malformed.
+    bool Compile(const std::string &format) {
+        const std::string text = format == "common" ? kCommonFormat : format == "combined" ? kCombinedFormat : format;
+        steps.clear();
+        std::string literal;
+        auto push = [&](Log_field field) {
+            steps.push_back(Step{literal, field, true});
+            literal.clear();
+        };
+
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\\' && i + 1 < text.size()) {
+                literal += text[++i];
+            }
+            else if (text[i] == '$') {
+                size_t end = i + 1;
+                while (end < text.size() && (isalnum(static_cast<unsigned char>(text[end])) || text[end] == '_')) {
+                    end++;
+                }
+                std::string name = text.substr(i + 1, end - i - 1);
+                i = end - 1;
+                push(name == "remote_addr" ? Log_field::Remote_addr :
+                     name == "time_local" ? Log_field::Local_time :
+                     name == "request" ? Log_field::Request :
+                     name == "status" ? Log_field::Status :
+                     name == "body_bytes_sent" || name == "bytes_sent" ? Log_field::Bytes_send :
+                     name == "http_referer" ? Log_field::Referer :
+                     name == "http_user_agent" ? Log_field::User_agent : Log_field::Skip);
+            }
+            else if (text[i] == '%' && i + 1 < text.size()) {
+                size_t end = i + 1;
+                std::string header;
+                if (text[end] == '>' || text[end] == '<') {
+                    end++;
+                }
+                if (text[end] == '{') {
+                    size_t close = text.find('}', end);
+                    if (close == std::string::npos) {
+                        return false;
+                    }
+                    header = text.substr(end + 1, close - end - 1);
+                    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+                    end = close + 1;
+                }
+                char directive = text[end];
+                i = end;
+                if (directive == '%') {
+                    literal += '%';
+                }
+                else if (directive == 't') {
+                    literal += '[';
+                    push(Log_field::Local_time);
+                    literal = "]";
+                }
+                else {
+                    push(directive == 'h' || directive == 'a' ? Log_field::Remote_addr :
+                         directive == 'r' ? Log_field::Request :
+                         directive == 's' ? Log_field::Status :
+                         directive == 'b' || directive == 'B' ? Log_field::Bytes_send :
+                         directive == 'i' && header == "referer" ? Log_field::Referer :
+                         directive == 'i' && header == "user-agent" ? Log_field::User_agent : Log_field::Skip);
+                }
+            }
+            else {
+                literal += text[i];
+            }
+        }
+        if (!literal.empty()) {
+            steps.push_back(Step{literal, Log_field::Skip, false});
+        }
+        if (text == kCommonFormat) {
+            for (auto &step : steps) {
+                step.up_to_last = step.field == Log_field::Request;
+            }
+        }
+        return true;
+    }
+
+    bool Parse(std::string_view line, Log_record &record) const {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        size_t position = 0;
+        for (size_t i = 0; i < steps.size(); i++) {
+            const Step &step = steps[i];
+            if (line.compare(position, step.literal.size(), step.literal) != 0) {
+                return false;
+            }
+            position += step.literal.size();
+            if (!step.has_field) {
+                continue;
+            }
+            size_t end = line.size();
+            if (i + 1 < steps.size()) {
+                end = step.up_to_last ? line.rfind(steps[i + 1].literal[0]) :
+                      steps[i + 1].literal.size() == 1 ? line.find(steps[i + 1].literal[0], position)
+                                                       : line.find(steps[i + 1].literal, position);
+                if (end == std::string_view::npos || end < position) {
+                    return false;
+                }
+            }
+            std::string_view value = line.substr(position, end - position);
+            switch (step.field) {
+                case Log_field::Remote_addr: record.remote_addr = value; break;
+                case Log_field::Local_time: record.local_time = value; break;
+                case Log_field::Request: record.request = value; break;
+                case Log_field::Status: record.status = value; break;
+                case Log_field::Bytes_send: record.bytes_send = value; break;
+                case Log_field::Referer: record.referer = value; break;
+                case Log_field::User_agent: record.user_agent = value; break;
+                case Log_field::Skip: break;
+            }
+            position = end;
+        }
+
+        return !record.local_time.empty();
+    }
+};
+
+bool Failed(const Log_record &record) {
+    return !record.status.empty() && record.status[0] == '5';
+}
+
+// IPv6 address as two 64-bit halves, IPv4 addresses being mapped into ::ffff:0:0/96.
+struct Ip_key {
+    uint64_t high = 0;
+    uint64_t low = 0;
+};
+
+bool Ip_bit(const Ip_key &key, int index) {
+    return index < 64 ? (key.high >> (63 - index)) & 1 : (key.low >> (127 - index)) & 1;
+}
+
+Ip_key Ip_mask(Ip_key key, int length) {
+    key.high = length == 0 ? 0 : length >= 64 ? key.high : key.high & (~0ull << (64 - length));
+    key.low = length <= 64 ? 0 : length == 128 ? key.low : key.low & (~0ull << (128 - length));
+    return key;
+}
+
+int Common_prefix(const Ip_key &lhs, const Ip_key &rhs, int limit) {
+    int common = lhs.high != rhs.high ? std::countl_zero(lhs.high ^ rhs.high)
+                                      : 64 + std::countl_zero(lhs.low ^ rhs.low);
+    return std::min(common, limit);
+}
+
+bool Parse_ipv4(std::string_view text, uint32_t &address) {
+    address = 0;
+    for (int part = 0; part < 4; part++) {
+        size_t end = part < 3 ? text.find('.') : text.size();
+        if (end == 0 || end == std::string_view::npos || end > 3) {
+            return false;
+        }
+        int value = 0;
+        for (char digit : text.substr(0, end)) {
+            if (!isdigit(static_cast<unsigned char>(digit))) {
+                return false;
+            }
+            value = value * 10 + digit - '0';
+        }
+        if (value > 255) {
+            return false;
+        }
+        address = (address << 8) | value;
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+
+    return true;
+}
+
+bool Parse_ip(std::string_view text, Ip_key &key) {
+    uint32_t ipv4 = 0;
+    if (text.find(':') == std::string_view::npos) {
+        if (!Parse_ipv4(text, ipv4)) {
+            return false;
+        }
+        key.high = 0;
+        key.low = 0xffff00000000ull | ipv4;
+        return true;
+    }
+
+    // a single colon only separates groups, at either end it is an empty group
+    if (text.back() == ':' && (text.size() < 2 || text[text.size() - 2] != ':')) {
+        return false;
+    }
+    // groups before and after "::"
+    std::array<uint16_t, 8> groups{};
+    int count[2] = {0, 0};
+    std::array<uint16_t, 8> tail{};
+    int side = 0;
+    size_t position = 0;
+    if (text.substr(0, 2) == "::") {
+        side = 1;
+        position = 2;
+    }
+    while (position < text.size()) {
+        size_t end = std::min(text.find(':', position), text.size());
+        std::string_view group = text.substr(position, end - position);
+        if (group.find('.') != std::string_view::npos) {
+            if (end != text.size() || !Parse_ipv4(group, ipv4) || count[0] + count[1] > 6) {
+                return false;
+            }
+            (side ? tail : groups)[count[side]++] = ipv4 >> 16;
+            (side ? tail : groups)[count[side]++] = ipv4 & 0xffff;
+            break;
+        }
+        if (group.empty() || group.size() > 4 || count[0] + count[1] >= 8 ||
+            group.find_first_not_of("0123456789abcdefABCDEF") != std::string_view::npos) {
+            return false;
+        }
+        (side ? tail : groups)[count[side]++] = strtoul(std::string(group).c_str(), nullptr, 16);
+        position = end + 1;
+        if (text.substr(end, 2) == "::") {
+            if (side == 1) {
+                return false;
+            }
+            side = 1;
+            position = end + 2;
+        }
+    }
+    if (side == 0 ? count[0] != 8 : count[0] + count[1] > 7) {
+        return false;
+    }
+    for (int i = 0; i < count[1]; i++) {
+        groups[8 - count[1] + i] = tail[i];
+    }
+    key.high = key.low = 0;
+    for (int i = 0; i < 4; i++) {
+        key.high = (key.high << 16) | groups[i];
+        key.low = (key.low << 16) | groups[i + 4];
+    }
+
+    return true;
+}
+
+// Compressed binary radix (PATRICIA) tree of CIDR ranges. Every node stores its whole prefix, so
+// a lookup walks at most one node per distinct prefix length on the path of the address, however
+// many ranges there are.
+struct Ip_tree {
+    struct Node {
+        Ip_key key;
+        int length = 0;
+        bool range = false;
+        int32_t child[2] = {-1, -1};
+    };
+
+    std::vector<Node> nodes = std::vector<Node>(1);
+
+    bool Empty() const {
+        return nodes.size() == 1 && !nodes[0].range;
+    }
+
+    int32_t New_node(const Ip_key &key, int length, bool range) {
+        Node node;
+        node.key = Ip_mask(key, length);
+        node.length = length;
+        node.range = range;
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    void Insert(const Ip_key &key, int length) {
+        int32_t current = 0;
+        while (nodes[current].length != length) {
+            bool bit = Ip_bit(key, nodes[current].length);
+            int32_t child = nodes[current].child[bit];
+            if (child == -1) {
+                int32_t leaf = New_node(key, length, true);
+                nodes[current].child[bit] = leaf;
+                return;
+            }
+            int common = Common_prefix(key, nodes[child].key, std::min(length, nodes[child].length));
+            if (common == nodes[child].length) {
+                current = child;
+                continue;
+            }
+            int32_t middle = New_node(key, common, common == length);
+            nodes[middle].child[Ip_bit(nodes[child].key, common)] = child;
+            if (common < length) {
+                int32_t leaf = New_node(key, length, true);
+                nodes[middle].child[Ip_bit(key, common)] = leaf;
+            }
+            nodes[current].child[bit] = middle;
+            return;
+        }
+        nodes[current].range = true;
+    }
+
+    bool Contains(const Ip_key &key) const {
+        int32_t current = 0;
+        while (!nodes[current].range) {
+            if (nodes[current].length == 128) {
+                return false;
+            }
+            int32_t child = nodes[current].child[Ip_bit(key, nodes[current].length)];
+            if (child == -1 || Common_prefix(key, nodes[child].key, nodes[child].length) < nodes[child].length) {
+                return false;
+            }
+            current = child;
+        }
+
+        return true;
+    }
+
+    // One "address" or "address/length" per line; empty lines and lines starting with # are skipped.
+    bool Load(const std::string &path) {
+        std::ifstream ranges(path);
+        if (!ranges.is_open()) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(ranges, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            size_t slash = line.find('/');
+            Ip_key key;
+            if (!Parse_ip(std::string_view(line).substr(0, slash), key)) {
+                std::cerr << "Invalid address range " << line << std::endl;
+                continue;
+            }
+            bool ipv4 = line.find(':') == std::string::npos;
+            int length = ipv4 ? 32 : 128;
+            if (slash != std::string::npos) {
+                // Only digits may follow the slash: "10.0.0.0/" or "10.0.0.0/abc" is not a /0.
+                std::string_view digits = std::string_view(line).substr(slash + 1);
+                length = digits.empty() || digits.size() > 3 ? -1 : 0;
+                for (char digit : digits) {
+                    if (!isdigit(static_cast<unsigned char>(digit))) {
+                        length = -1;
+                        break;
+                    }
+                    length = length * 10 + digit - '0';
+                }
+            }
+            if (length < 0 || length > (ipv4 ? 32 : 128)) {
+                std::cerr << "Invalid address range " << line << std::endl;
+                continue;
+            }
+            Insert(key, ipv4 ? length + 96 : length);
+        }
+        return true;
+    }
+};
+
 struct Arguments_for_prog {
     std::string path_to_file = "";
     std::string file_final;
@@ -18,10 +416,61 @@ struct Arguments_for_prog {
     int time = 0;
     time_t to_time = 0;
     time_t from_time = 0;
-    int len_file = 0;
     bool to_time_flag = false;
+    size_t max_memory = 0;
+    double sample = 1;
+    bool sample_lines = false;
+    int prefix_depth = 0;
+    int session_gap = 0;
+    int failing_window = 0;
+    int failing_step = 0;
+    std::string rollup_file;
+    bool serve = false;
+    std::vector<std::string> log_files;
+    std::string log_format = "common";
+    Log_format format;
+    int peaks = 0;
+    double anomalies = 0;
+    Ip_tree include_ips;
+    Ip_tree exclude_ips;
 };
 
+// Rough cost of one std::map<std::string, int> node on top of the key characters.
+const size_t kMapNodeOverhead = 96;
+// How many sorted runs are merged at once, so that open files stay bounded.
+const size_t kMaxMergeRuns = 64;
+// Unit of block sampling: unsampled blocks are never read.
+const size_t kSampleBlock = 1 << 20;
+// How far out of order log times may be, in seconds, for the --from seek and the --to cut-off.
+const time_t kTimeJitter = 300;
+// The --from binary search stops once its range is this small, in bytes.
+const uint64_t kSeekPrecision = 1 << 12;
+// Bytes read between two checks of the --to cut-off.
+const uint64_t kTimeCheck = 1 << 16;
+// 5XX lines closer than this in bytes are exported by one read of the span between them.
+const uint64_t kCopyGap = 1 << 12;
+// Weight of the newest second in the baseline and in the score of --anomalies.
+const double kAnomalyAlpha = 0.01;
+const double kAnomalyFast = 0.2;
+// Seconds of traffic the --anomalies averages see before anything is reported.
+const long long kAnomalyWarmup = 30;
+// Share of kAnomalyAlpha by which the baseline still moves during an anomaly, so that it is not
+// only ever fed the quiet seconds.
+const double kAnomalyDrift = 0.25;
+// Longest anomaly, in seconds: past that the error rate is taken to have changed for good, the
+// anomaly is reported and its rate becomes the baseline.
+const long long kAnomalyMaxSeconds = 120;
+// Shortest anomaly reported, in seconds, and the fewest 5XX requests in it: single-second spikes
+// of a few errors are common at low request rates.
+const long long kAnomalyMinSeconds = 5;
+const long long kAnomalyMinFailed = 10;
+// Capacity of the path trie; deeper paths that no longer fit are counted at their longest stored prefix.
+const uint32_t kMaxTrieNodes = 1 << 20;
+// Bytes at each end of a log that are hashed to tell whether a rollup is still up to date.
+const uint64_t kStampBytes = 1 << 16;
+// Most clients kept in an open session; the least recently seen one is closed early beyond that.
+const size_t kMaxActiveClients = 1 << 20;
+
 int Converter_Num_Month(const std::string month) {
     char months[][12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
     for (int i = 0; i < 12; ++i) {
@@ -34,7 +483,7 @@ int Converter_Num_Month(const std::string month) {
 }
 
 time_t Converter_Time(const std::string date) {
-    struct tm Full_date_form;
+    struct tm Full_date_form = {};
 
     Full_date_form.tm_mday = std::stoi(date.substr(0, date.find('/')));
     Full_date_form.tm_mon = Converter_Num_Month(date.substr(date.find('/') + 1, 3));
@@ -46,11 +495,29 @@ time_t Converter_Time(const std::string date) {
     return mktime(&Full_date_form);
 }
 
-void Parsing_arg(Arguments_for_prog &arguments, int argc, char* argv[]) {
+size_t Converter_Memory(const std::string value) {
+    size_t number = strtoull(value.c_str(), nullptr, 10);
+    switch (value.empty() ? ' ' : toupper(value.back())) {
+        case 'G':
+            number *= 1024;
+            [[fallthrough]];
+        case 'M':
+            number *= 1024;
+            [[fallthrough]];
+        case 'K':
+            number *= 1024;
+    }
+
+    return number;
+}
+
+// False if the arguments cannot be run at all.
+bool Parsing_arg(Arguments_for_prog &arguments, int argc, char* argv[]) {
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
-        if (arg.find(".log") != -1) {
+        if (arg.find(".log") != -1 || arg == "-") {
             arguments.path_to_file = arg.c_str();
+            arguments.log_files.push_back(arg);
         }
         else if (arg == "-o") {
             arguments.file_final = argv[i + 1];
@@ -70,11 +537,11 @@ void Parsing_arg(Arguments_for_prog &arguments, int argc, char* argv[]) {
         else if (arg == "-f") {
             arguments.from_time = atoi(argv[i + 1]);
             i++;
-            arguments.to_time_flag = true;
         }
         else if (arg == "-e") {
             arguments.to_time = atoi(argv[i + 1]);
             i++;
+            arguments.to_time_flag = true;
         }
         else if (arg.find("--output=") != std::string::npos) {
             arguments.file_final = arg.substr(9).c_str(); 
@@ -87,10 +554,58 @@ void Parsing_arg(Arguments_for_prog &arguments, int argc, char* argv[]) {
         }
         else if (arg.find("--from=") != std::string::npos) {
             arguments.from_time = atoi(arg.substr(7).c_str());
-            arguments.to_time_flag = true;
         }
         else if (arg.find("--to=") != std::string::npos) {
             arguments.to_time = atoi(arg.substr(5).c_str());
+            arguments.to_time_flag = true;
+        }
+        else if (arg.find("--max-memory=") != std::string::npos) {
+            arguments.max_memory = Converter_Memory(arg.substr(13));
+        }
+        else if (arg.find("--sample=") != std::string::npos) {
+            arguments.sample = atof(arg.substr(9).c_str());
+        }
+        else if (arg == "--sample-lines") {
+            arguments.sample_lines = true;
+        }
+        else if (arg.find("--prefix-depth=") != std::string::npos) {
+            arguments.prefix_depth = atoi(arg.substr(15).c_str());
+        }
+        else if (arg.find("--session-gap=") != std::string::npos) {
+            arguments.session_gap = atoi(arg.substr(14).c_str());
+        }
+        else if (arg.find("--failing-window=") != std::string::npos) {
+            arguments.failing_window = atoi(arg.substr(17).c_str());
+        }
+        else if (arg.find("--failing-step=") != std::string::npos) {
+            arguments.failing_step = atoi(arg.substr(15).c_str());
+        }
+        else if (arg.find("--rollup=") != std::string::npos) {
+            arguments.rollup_file = arg.substr(9);
+        }
+        else if (arg == "--serve") {
+            arguments.serve = true;
+        }
+        else if (arg.find("--log-format=") != std::string::npos) {
+            arguments.log_format = arg.substr(13);
+        }
+        else if (arg.find("--peaks=") != std::string::npos) {
+            arguments.peaks = atoi(arg.substr(8).c_str());
+        }
+        else if (arg.find("--anomalies=") != std::string::npos) {
+            arguments.anomalies = atof(arg.substr(12).c_str());
+        }
+        else if (arg.find("--include-ips=") != std::string::npos) {
+            if (!arguments.include_ips.Load(arg.substr(14))) {
+                std::cerr << "The file " << arg.substr(14) << " did not open" << std::endl;
+                return false;
+            }
+        }
+        else if (arg.find("--exclude-ips=") != std::string::npos) {
+            if (!arguments.exclude_ips.Load(arg.substr(14))) {
+                std::cerr << "The file " << arg.substr(14) << " did not open" << std::endl;
+                return false;
+            }
         }
         else if (arg.find("--print") != std::string::npos) {
             arguments.print = true;
@@ -104,167 +619,1564 @@ void Parsing_arg(Arguments_for_prog &arguments, int argc, char* argv[]) {
     if (arguments.path_to_file == ""){
         std:: cerr << "The file did not open, please retry the request with a .log file" << std::endl;
     }
-    std::ifstream work_with_file;
+    // Every pass but the main one reads the log again, and stdin can only be read once.
+    if (arguments.path_to_file == "-" && (arguments.time != 0 || arguments.session_gap != 0 ||
+                                          arguments.failing_window != 0 || !arguments.rollup_file.empty() ||
+                                          arguments.serve)) {
+        std::cerr << "--window, --session-gap, --failing-window, --rollup and --serve need a log file, "
+                  << "they cannot read the log from stdin" << std::endl;
+        return false;
+    }
+    if (!arguments.format.Compile(arguments.log_format)) {
+        std::cerr << "Invalid log format " << arguments.log_format << ": %{ is not closed by }" << std::endl;
+        return false;
+    }
+    if (!arguments.to_time_flag){
+        arguments.to_time = std::numeric_limits<time_t>::max();
+    }
+    if (arguments.failing_step <= 0){
+        arguments.failing_step = arguments.failing_window;
+    }
+    if (arguments.sample <= 0 || arguments.sample >= 1){
+        arguments.sample = 1;
+    }
+    return true;
+}
+
+// --include-ips and --exclude-ips. Host names never fall into a range: they are dropped by
+// --include-ips and kept by --exclude-ips.
+bool Wanted(const Arguments_for_prog &arguments, const Log_record &record) {
+    if (arguments.include_ips.Empty() && arguments.exclude_ips.Empty()) {
+        return true;
+    }
+    Ip_key key;
+    if (!Parse_ip(record.remote_addr, key)) {
+        return arguments.include_ips.Empty();
+    }
+
+    return (arguments.include_ips.Empty() || arguments.include_ips.Contains(key)) &&
+           (arguments.exclude_ips.Empty() || !arguments.exclude_ips.Contains(key));
+}
+
+bool Sampled(uint64_t unit, double sample) {
+    // splitmix64, so that the same file and rate always give the same subset
+    uint64_t hash = unit + 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+
+    return hash < sample * 18446744073709551616.0;
+}
+
+// Half-width of the 95% confidence interval of a total scaled up by 1 / sample,
+// squares being the sum of squared counts per sampled unit.
+double Sample_error(double squares, double sample) {
+    return 1.96 * sqrt((1 - sample) * squares) / sample;
+}
+
+// Time of a log line, or -1 if it does not match the format.
+time_t Line_time(const Log_format &format, const std::string &line) {
+    Log_record record;
+    if (!format.Parse(line, record)) {
+        return -1;
+    }
+
+    return Converter_Time(std::string(record.local_time));
+}
+
+// Offset of the first line that starts at or after offset.
+uint64_t Line_start(std::ifstream &work_with_file, uint64_t offset, uint64_t size) {
+    if (offset == 0) {
+        return 0;
+    }
     std::string line;
-    time_t value_data;
-    std::string data;
-    work_with_file.open(arguments.path_to_file);
-    while (std::getline(work_with_file, line)){
-        if (line.length() < 15){
-            continue;
+    work_with_file.clear();
+    work_with_file.seekg(offset - 1);
+    if (!std::getline(work_with_file, line)) {
+        return size;
+    }
+
+    return offset + line.size();
+}
+
+// Binary search for the first line with a time of at least target, for logs in time order.
+// Lines that do not parse are skipped; the search keeps the last offset known to be before target.
+uint64_t Seek_time(const Log_format &format, std::ifstream &work_with_file, uint64_t size, time_t target) {
+    uint64_t low = 0, high = size;
+    std::string line;
+    while (high - low > kSeekPrecision) {
+        uint64_t middle = low + (high - low) / 2;
+        uint64_t position = Line_start(work_with_file, middle, size);
+        time_t time = -1;
+        while (time == -1 && position < high && std::getline(work_with_file, line)) {
+            time = Line_time(format, line);
+            position += line.size() + 1;
         }
-        data = line.substr(line.find("[") + 1, line.rfind("]") - line.find("[") - 1);
-        value_data = Converter_Time(data);
-        if (arguments.from_time == 0){
-            arguments.from_time = value_data;
+        if (time == -1 || time >= target) {
+            high = middle;
         }
-        if (!arguments.to_time_flag){
-            arguments.to_time = value_data;
+        else {
+            low = middle;
         }
-        arguments.len_file++;
-       }
-}
-
+    }
 
-void Parser(Arguments_for_prog & arguments){
-    std::ofstream file_with_5XX; 
-    std::ofstream n_stats_file;
-    std::ifstream work_with_file;
-    std::string n_stats = "stats.txt";
+    return Line_start(work_with_file, low, size);
+}
 
-    std::map<std::string, int> unsorted_5XX;
-    std::vector<std::string> requested;
-    
-    
-    std::string request;
-    std::string data;
-    int i_req = 0;
-    int counter = 0;
+// Passes every line of the log ("-" for stdin) and its byte offset to handle, or only the sampled subset when --sample is set.
+// With block sampling new_block is called before each sampled block and the others are skipped
+// without being read; a line belongs to the block in which it starts.
+// With --from reading starts at the offset found by Seek_time, and with --to it ends at the first
+// checked line past it, both kTimeJitter seconds wider than asked; handle still has to filter by time.
+bool Read_log(const Arguments_for_prog &arguments, const std::function<void(const std::string&, uint64_t)> &handle,
+              const std::function<void()> &new_block = [] {}) {
+    std::string line;
+    if (arguments.path_to_file == "-") {
+        // stdin can only be read once and in order
+        for (uint64_t position = 0; std::getline(std::cin, line); position += line.size() + 1) {
+            handle(line, position);
+        }
+        return true;
+    }
+    std::ifstream work_with_file(arguments.path_to_file);
+    if (!work_with_file.is_open()) {
+        return false;
+    }
+    uint64_t size = std::filesystem::file_size(arguments.path_to_file);
+    uint64_t begin = 0;
+    if (arguments.from_time > 0) {
+        begin = Seek_time(arguments.format, work_with_file, size, arguments.from_time - kTimeJitter);
+    }
+    time_t stop = arguments.to_time_flag ? arguments.to_time + kTimeJitter : std::numeric_limits<time_t>::max();
+    auto past_end = [&]() {
+        return stop != std::numeric_limits<time_t>::max() && Line_time(arguments.format, line) > stop;
+    };
 
-    file_with_5XX.open(arguments.file_final);
-    work_with_file.open(arguments.path_to_file);
-    if (work_with_file.is_open()){
-        std::string line;
-        time_t value_data;
-        while (std::getline(work_with_file, line)){
-            if (line[line.rfind('"') + 2] == '5'){
-                if (line.length() < 15){
-                    continue;
-                }
-                data = line.substr(line.find("[") + 1, line.rfind("]") - line.find("[") - 1);
-                value_data = Converter_Time(data);
-                if (arguments.from_time <= value_data <= arguments.to_time){
-                    if (arguments.print) {
-                        std::cout << line << std::endl;
-                    }
-                    file_with_5XX << line << std::endl;
-                    i_req = line.find('"') + 1;
-                    request = "";
-                    while (i_req != line.rfind('"')){
-                        request += line[i_req];
-                        i_req += 1;
-                    }
-                    if ((unsorted_5XX).find(request) != (unsorted_5XX).end()){
-                        unsorted_5XX[request] = unsorted_5XX[request] + 1;
-                    }
-                    else{
-                        unsorted_5XX[request] = 1;
-                        counter += 1;
-                    } 
+    if (arguments.sample == 1 || arguments.sample_lines) {
+        uint64_t position = begin, check = begin;
+        work_with_file.clear();
+        work_with_file.seekg(begin);
+        while (std::getline(work_with_file, line)) {
+            if (position >= check) {
+                if (past_end()) {
+                    break;
                 }
+                check = position + kTimeCheck;
+            }
+            if (arguments.sample == 1 || Sampled(position, arguments.sample)) {
+                handle(line, position);
             }
+            position += line.size() + 1;
         }
+        return true;
     }
-    else {
-        std::cerr << "Not open" << std::endl;
-    }
-    n_stats_file.open(n_stats);
-    int second = 0;
-    std::string first;
-    std::cout << "Most popular n  request" << std::endl;
-    if (n_stats_file.is_open()){
-        while(unsorted_5XX.size() > 0 && arguments.n_stats != 0){
-            for (auto pair : unsorted_5XX){
-                if (pair.second > second){
-                    second = pair.second;
-                    first = pair.first;
-                }
+
+    for (uint64_t block = begin / kSampleBlock; block * kSampleBlock < size; block++) {
+        if (!Sampled(block, arguments.sample)) {
+            continue;
+        }
+        uint64_t position = Line_start(work_with_file, std::max(block * kSampleBlock, begin), size);
+        uint64_t end = (block + 1) * kSampleBlock;
+        work_with_file.clear();
+        work_with_file.seekg(position);
+        new_block();
+        bool first = true;
+        while (position < end && std::getline(work_with_file, line)) {
+            if (first && past_end()) {
+                return true;
             }
-        
-            unsorted_5XX.erase(first);
-            arguments.n_stats--;
-            n_stats_file << first << " " << second << std::endl;
-            std::cout << first << " " << second << std::endl;
-            second = 0; 
-    }       
+            first = false;
+            handle(line, position);
+            position += line.size() + 1;
+        }
     }
-    n_stats_file.close();
-    file_with_5XX.close();
-    work_with_file.close();
-}
 
-void P_for_window(Arguments_for_prog & arguments) {
-    std::ifstream file_for_time(arguments.path_to_file);
-    std::vector<time_t> mas(arguments.len_file);
+    return true;
+}
 
-    int maximum_request = 0;
-    time_t left = arguments.from_time, right = arguments.to_time;
-    time_t left_req_in_time = 0, right_req_in_time = 0;
-    int last_id = 0, first_id = 0;
-    int counter = 0;
-    int time_limit = arguments.time;
+std::filesystem::path New_run() {
+    static std::random_device seed;
+    return std::filesystem::temp_directory_path() / ("AnalyzeLog_" + std::to_string(seed()) + ".run");
+}
 
-    if (!file_for_time.is_open()) {
-        std::cerr << "Error opening file." << std::endl;
-        return;
+std::filesystem::path Spill_run(std::map<std::string, int> &requests) {
+    std::filesystem::path run = New_run();
+    std::ofstream run_file(run);
+    for (auto &pair : requests) {
+        run_file << pair.first << '\t' << pair.second << '\n';
     }
+    requests.clear();
 
-    std::cout << "File opened successfully." << std::endl;
+    return run;
+}
+
+bool Read_run(std::ifstream &run_file, std::string &request, int &count) {
     std::string line;
+    if (!std::getline(run_file, line)) {
+        return false;
+    }
+    request = line.substr(0, line.rfind('\t'));
+    count = atoi(line.c_str() + line.rfind('\t') + 1);
 
-    while (std::getline(file_for_time, line)) {
-        if (line.length() < 15){
-            continue;
+    return true;
+}
+
+// K-way merge of runs sorted by request; equal requests are summed before being passed on.
+void Merge_runs(const std::vector<std::filesystem::path> &runs,
+                const std::function<void(const std::string&, int)> &consumer) {
+    using Head = std::pair<std::string, size_t>;
+    std::vector<std::ifstream> run_files;
+    std::vector<int> counts(runs.size());
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+
+    for (size_t i = 0; i < runs.size(); i++) {
+        run_files.emplace_back(runs[i]);
+        std::string request;
+        if (Read_run(run_files[i], request, counts[i])) {
+            heads.emplace(request, i);
         }
-        std::string data = line.substr(line.find("[") + 1, line.rfind("]") - line.find("[") - 1);
-        time_t conv_date = Converter_Time(data);
+    }
 
-        if (conv_date >= left && conv_date <= right) {
-            
-            if (first_id < arguments.len_file) {
-                mas[first_id] = conv_date;
+    while (!heads.empty()) {
+        std::string request = heads.top().first;
+        int total = 0;
+        while (!heads.empty() && heads.top().first == request) {
+            size_t i = heads.top().second;
+            heads.pop();
+            total += counts[i];
+            std::string next;
+            if (Read_run(run_files[i], next, counts[i])) {
+                heads.emplace(next, i);
+            }
+        }
+        consumer(request, total);
+    }
+}
 
-                if (left_req_in_time == 0 && right_req_in_time == 0) {
-                    left_req_in_time = right_req_in_time = conv_date;
-                }
+// Merges runs in groups of kMaxMergeRuns until a single pass over all of them is possible.
+void Reduce_runs(std::vector<std::filesystem::path> &runs) {
+    while (runs.size() > kMaxMergeRuns) {
+        std::vector<std::filesystem::path> merged;
+        for (size_t i = 0; i < runs.size(); i += kMaxMergeRuns) {
+            std::vector<std::filesystem::path> group(runs.begin() + i,
+                                                     runs.begin() + std::min(runs.size(), i + kMaxMergeRuns));
+            std::filesystem::path run = New_run();
+            std::ofstream run_file(run);
+            Merge_runs(group, [&run_file](const std::string &request, int count) {
+                run_file << request << '\t' << count << '\n';
+            });
+            for (auto &path : group) {
+                std::filesystem::remove(path);
+            }
+            merged.push_back(run);
+        }
+        runs = merged;
+    }
+}
 
-                right_req_in_time = conv_date;
-                counter++;
-                first_id++;
+// Most frequent first, ties broken by the request itself.
+struct Less_popular {
+    bool operator()(const std::pair<std::string, int> &lhs, const std::pair<std::string, int> &rhs) const {
+        if (lhs.second != rhs.second) {
+            return lhs.second > rhs.second;
+        }
+        return lhs.first < rhs.first;
+    }
+};
 
-                while (right_req_in_time - left_req_in_time > time_limit && last_id < first_id) {
-                    left_req_in_time = mas[++last_id];
-                    counter--;
-                }
+std::vector<std::pair<std::string, int>> Top_requests(std::map<std::string, int> &requests,
+                                                      std::vector<std::filesystem::path> &runs, int n_stats) {
+    std::priority_queue<std::pair<std::string, int>, std::vector<std::pair<std::string, int>>, Less_popular> top;
+    auto consumer = [&top, n_stats](const std::string &request, int count) {
+        if (n_stats == 0) {
+            return;
+        }
+        top.emplace(request, count);
+        if (n_stats > 0 && top.size() > static_cast<size_t>(n_stats)) {
+            top.pop();
+        }
+    };
 
-                maximum_request = std::max(maximum_request, counter);
-            } else {
-                std::cerr << "Warning: first_id exceeded array bounds." << std::endl;
-            }
+    if (runs.empty()) {
+        for (auto &pair : requests) {
+            consumer(pair.first, pair.second);
         }
     }
+    else {
+        if (!requests.empty()) {
+            runs.push_back(Spill_run(requests));
+        }
+        Reduce_runs(runs);
+        Merge_runs(runs, consumer);
+        for (auto &path : runs) {
+            std::filesystem::remove(path);
+        }
+        runs.clear();
+    }
 
-    std::cout << "Maximum request count: " << maximum_request << std::endl;
+    std::vector<std::pair<std::string, int>> result;
+    while (!top.empty()) {
+        result.push_back(top.top());
+        top.pop();
+    }
+    std::reverse(result.begin(), result.end());
+
+    return result;
 }
 
-int main(int argc, char* argv[]) {
-    Arguments_for_prog args;
-    Parsing_arg(args, argc, argv);
-    if (args.path_to_file != ""){
-        Parser(args);
+// "GET /shuttle/countdown/?id=1 HTTP/1.0" -> "/shuttle/countdown/"
+std::string_view Request_path(std::string_view request) {
+    size_t begin = request.find(' ');
+    begin = (begin == std::string_view::npos) ? 0 : begin + 1;
+    size_t end = std::min({request.find('?', begin), request.find(' ', begin), request.find("HTTP/", begin),
+                           request.size()});
+
+    return request.substr(begin, end - begin);
+}
+
+// Trie over path segments ("shuttle/", "countdown/"), every node counting the requests below it.
+// Nodes live in one vector and link to their first child and next sibling by index; labels are
+// slices of a shared character pool. Children are found through an open-addressing table keyed
+// by (parent, label), so a lookup does not depend on how many siblings there are.
+struct Path_trie {
+    struct Node {
+        uint32_t label_begin = 0;
+        uint32_t parent = 0;
+        uint32_t first_child = 0;
+        uint32_t next_sibling = 0;
+        uint32_t count = 0;
+        uint32_t ends = 0;
+        uint16_t label_length = 0;
+    };
+
+    std::vector<Node> nodes = std::vector<Node>(1);
+    std::string labels;
+    // node indices, 0 for an empty slot; the size is a power of two at least twice the node count
+    std::vector<uint32_t> slots = std::vector<uint32_t>(1024);
+    uint64_t truncated = 0;
+
+    std::string_view Label(const Node &node) const {
+        return std::string_view(labels).substr(node.label_begin, node.label_length);
     }
-    if (args.time != 0){
-        P_for_window(args);
+
+    size_t Slot(uint32_t parent, std::string_view label) const {
+        size_t hash = std::hash<std::string_view>()(label) ^ (parent * 0x9e3779b97f4a7c15ull);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            const Node &node = nodes[slots[slot]];
+            if (slots[slot] == 0 || (node.parent == parent && Label(node) == label)) {
+                return slot;
+            }
+        }
+    }
+
+    void Grow() {
+        slots.assign(slots.size() * 2, 0);
+        for (uint32_t node = 1; node < nodes.size(); node++) {
+            slots[Slot(nodes[node].parent, Label(nodes[node]))] = node;
+        }
+    }
+
+    // Finds the child with the given label, adding it if there is none. Returns 0 if it has to be
+    // added but the trie is full.
+    uint32_t Child(uint32_t parent, std::string_view label) {
+        size_t slot = Slot(parent, label);
+        if (slots[slot] != 0) {
+            return slots[slot];
+        }
+        if (nodes.size() >= kMaxTrieNodes || label.size() > UINT16_MAX) {
+            return 0;
+        }
+        Node node;
+        node.label_begin = labels.size();
+        node.label_length = label.size();
+        node.parent = parent;
+        node.next_sibling = nodes[parent].first_child;
+        labels.append(label);
+        nodes.push_back(node);
+        uint32_t child = nodes.size() - 1;
+        nodes[parent].first_child = child;
+        slots[slot] = child;
+        if (nodes.size() * 2 > slots.size()) {
+            Grow();
+        }
+
+        return child;
+    }
+
+    void Add(std::string_view path) {
+        uint32_t current = 0;
+        nodes[0].count++;
+        size_t begin = path.empty() || path[0] != '/' ? 0 : 1;
+        while (begin < path.size()) {
+            size_t end = std::min(path.find('/', begin), path.size() - 1) + 1;
+            uint32_t child = Child(current, path.substr(begin, end - begin));
+            if (child == 0) {
+                truncated++;
+                break;
+            }
+            current = child;
+            nodes[current].count++;
+            begin = end;
+        }
+        nodes[current].ends++;
+    }
+
+    // Counts per prefix of exactly depth segments; paths that are shorter are reported whole.
+    void Collect(uint32_t node, int depth, std::string &prefix, std::map<std::string, int> &result) const {
+        if (depth == 0) {
+            result[prefix] = nodes[node].count;
+            return;
+        }
+        if (nodes[node].ends != 0) {
+            result[prefix] = nodes[node].ends;
+        }
+        for (uint32_t child = nodes[node].first_child; child != 0; child = nodes[child].next_sibling) {
+            size_t length = prefix.size();
+            prefix.append(Label(nodes[child]));
+            Collect(child, depth - 1, prefix, result);
+            prefix.resize(length);
+        }
+    }
+
+    std::map<std::string, int> Prefixes(int depth) const {
+        std::map<std::string, int> result;
+        std::string prefix = "/";
+        Collect(0, depth, prefix, result);
+
+        return result;
+    }
+};
+
+// Writes lines of the log to the output file as byte ranges of the input, so that a run of
+// adjacent lines becomes a single copy (copy_file_range on Linux, a buffered copy elsewhere).
+// Ranges less than kCopyGap apart are gathered by one read of the span around them and written
+// from memory, so that sparse lines do not cost a copy each.
+struct Range_copier {
+    std::string source_path;
+    uint64_t source_size = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> pieces;
+    bool missing_newline = false;
+#ifdef __linux__
+    int source = -1;
+    int target = -1;
+#else
+    std::ifstream source;
+    std::ofstream target;
+#endif
+
+    bool Open(const std::string &from, const std::string &to) {
+        source_path = from;
+        source_size = std::filesystem::file_size(from);
+#ifdef __linux__
+        source = open(from.c_str(), O_RDONLY);
+        target = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return source != -1 && target != -1;
+#else
+        source.open(from, std::ios::binary);
+        target.open(to, std::ios::binary);
+        return source.is_open() && target.is_open();
+#endif
+    }
+
+    void Add(uint64_t offset, uint64_t length) {
+        uint64_t end = std::min(offset + length, source_size);
+        if (!pieces.empty() && offset == pieces.back().second) {
+            pieces.back().second = end;
+        }
+        else {
+            if (!pieces.empty() && (offset < pieces.back().second || offset - pieces.back().second >= kCopyGap ||
+                                    end - pieces.front().first > kSampleBlock)) {
+                Flush();
+            }
+            pieces.emplace_back(offset, end);
+        }
+        if (offset + length > source_size) {
+            // the last line of the log has no newline of its own
+            missing_newline = true;
+        }
+    }
+
+    bool Write(const char *data, size_t size) {
+#ifdef __linux__
+        while (size > 0) {
+            ssize_t written = write(target, data, size);
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+#else
+        target.write(data, size);
+        return static_cast<bool>(target);
+#endif
+    }
+
+    bool Read(char *data, uint64_t offset, size_t size) {
+#ifdef __linux__
+        while (size > 0) {
+            ssize_t got = pread(source, data, size, offset);
+            if (got <= 0) {
+                return false;
+            }
+            data += got;
+            offset += got;
+            size -= got;
+        }
+        return true;
+#else
+        source.clear();
+        source.seekg(offset);
+        source.read(data, size);
+        return static_cast<size_t>(source.gcount()) == size;
+#endif
+    }
+
+    bool Copy(uint64_t begin, uint64_t end) {
+#ifdef __linux__
+        loff_t offset = begin;
+        while (offset < static_cast<loff_t>(end)) {
+            ssize_t copied = copy_file_range(source, &offset, target, nullptr, end - offset, 0);
+            if (copied > 0) {
+                continue;
+            }
+            if (copied == -1 && errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP) {
+                return false;
+            }
+            // file systems without copy_file_range support
+            std::vector<char> buffer(std::min<uint64_t>(end - offset, kSampleBlock));
+            if (!Read(buffer.data(), offset, buffer.size()) || !Write(buffer.data(), buffer.size())) {
+                return false;
+            }
+            offset += buffer.size();
+        }
+        return true;
+#else
+        std::vector<char> buffer(end - begin);
+        return Read(buffer.data(), begin, buffer.size()) && Write(buffer.data(), buffer.size());
+#endif
+    }
+
+    // Reads the whole span of the pieces and moves them together before a single write.
+    bool Gather() {
+        uint64_t first = pieces.front().first;
+        std::vector<char> buffer(pieces.back().second - first);
+        if (!Read(buffer.data(), first, buffer.size())) {
+            return false;
+        }
+        size_t length = 0;
+        for (auto &piece : pieces) {
+            std::memmove(buffer.data() + length, buffer.data() + (piece.first - first), piece.second - piece.first);
+            length += piece.second - piece.first;
+        }
+        return Write(buffer.data(), length);
+    }
+
+    void Flush() {
+        bool written = pieces.empty() || (pieces.size() == 1 ? Copy(pieces[0].first, pieces[0].second) : Gather());
+        if (written && missing_newline) {
+            written = Write("\n", 1);
+        }
+        if (!written) {
+            std::cerr << "Failed to copy 5XX requests to the output file" << std::endl;
+        }
+        pieces.clear();
+        missing_newline = false;
+    }
+
+    ~Range_copier() {
+        Flush();
+#ifdef __linux__
+        if (source != -1) {
+            close(source);
+        }
+        if (target != -1) {
+            close(target);
+        }
+#endif
+    }
+};
+
+// Error rate per second of log time against a baseline kept as slow exponentially weighted averages.
+// Every second gives a binomial residual (failed - total * p) / sqrt(total * p * (1 - p)); a fast
+// average of the residuals is the score, compared with threshold times its own standard deviation,
+// which comes from a slow average of squared residuals. Seconds above the threshold move the
+// baseline kAnomalyDrift times slower than the others, and a run of them is reported as one range
+// as soon as it ends, so the detector also works on a log read from stdin. Runs shorter than
+// kAnomalyMinSeconds or with fewer than kAnomalyMinFailed 5XX requests are dropped, and a run that
+// reaches kAnomalyMaxSeconds is reported at once, its rate becoming the baseline.
+struct Anomaly_detector {
+    double threshold = 0;
+    time_t second = std::numeric_limits<time_t>::min();
+    long long total = 0;
+    long long failed = 0;
+    long long seconds = 0;
+    double total_mean = 0;
+    double failed_mean = 0;
+    double residual_variance = 1;
+    double score = 0;
+    time_t anomaly_begin = 0;
+    time_t anomaly_end = 0;
+    double anomaly_rate = -1;
+    long long anomaly_seconds = 0;
+    long long anomaly_total = 0;
+    long long anomaly_failed = 0;
+
+    void Add(time_t time, bool is_failed) {
+        if (time > second) {
+            Close_second();
+            second = time;
+        }
+        total++;
+        failed += is_failed;
+    }
+
+    double Baseline() const {
+        return total_mean == 0 ? 0 : failed_mean / total_mean;
+    }
+
+    void Close_second() {
+        if (total == 0) {
+            return;
+        }
+        double rate = static_cast<double>(failed) / total;
+        double p = std::clamp(Baseline(), 1e-3, 1 - 1e-3);
+        double residual = (failed - total * p) / sqrt(total * p * (1 - p));
+        score += kAnomalyFast * (residual - score);
+        double spread = sqrt(kAnomalyFast / (2 - kAnomalyFast) * residual_variance);
+        if (seconds >= kAnomalyWarmup && score > threshold * spread) {
+            if (anomaly_rate < 0) {
+                anomaly_begin = second;
+                anomaly_seconds = anomaly_total = anomaly_failed = 0;
+            }
+            anomaly_end = second;
+            anomaly_rate = std::max(anomaly_rate, rate);
+            anomaly_seconds++;
+            anomaly_total += total;
+            anomaly_failed += failed;
+            total_mean += kAnomalyDrift * kAnomalyAlpha * (total - total_mean);
+            failed_mean += kAnomalyDrift * kAnomalyAlpha * (failed - failed_mean);
+            if (anomaly_seconds == kAnomalyMaxSeconds) {
+                Report();
+                total_mean = static_cast<double>(anomaly_total) / anomaly_seconds;
+                failed_mean = static_cast<double>(anomaly_failed) / anomaly_seconds;
+                score = 0;
+            }
+        }
+        else {
+            Report();
+            total_mean += kAnomalyAlpha * (total - total_mean);
+            failed_mean += kAnomalyAlpha * (failed - failed_mean);
+            residual_variance += kAnomalyAlpha * (residual * residual - residual_variance);
+            seconds++;
+        }
+        total = failed = 0;
+    }
+
+    void Report() {
+        if (anomaly_rate < 0) {
+            return;
+        }
+        if (anomaly_seconds >= kAnomalyMinSeconds && anomaly_failed >= kAnomalyMinFailed) {
+            std::cout << "Error rate anomaly: " << anomaly_begin << " - " << anomaly_end << ", 5XX rate up to "
+                      << anomaly_rate << " against " << Baseline() << std::endl;
+        }
+        anomaly_rate = -1;
+    }
+
+    void Finish() {
+        Close_second();
+        Report();
+    }
+};
+
+void Parser(Arguments_for_prog & arguments){
+    Range_copier file_with_5XX;
+    std::ofstream n_stats_file;
+    std::string n_stats = "stats.txt";
+
+    std::map<std::string, int> unsorted_5XX;
+    std::vector<std::filesystem::path> runs;
+    size_t table_memory = 0;
+    Path_trie prefixes;
+    
+    
+    std::string request;
+    int counter = 0;
+    long long count_5XX = 0, block_5XX = 0, sampled_lines = 0;
+    double squares_5XX = 0;
+    auto close_block = [&]() {
+        squares_5XX += static_cast<double>(block_5XX) * block_5XX;
+        block_5XX = 0;
+    };
+
+    Anomaly_detector anomalies;
+    anomalies.threshold = arguments.anomalies;
+
+    bool output = !arguments.file_final.empty() && std::filesystem::exists(arguments.path_to_file) &&
+                  file_with_5XX.Open(arguments.path_to_file, arguments.file_final);
+    // lines from stdin cannot be copied as ranges of the input
+    std::ofstream stream_with_5XX;
+    if (!arguments.file_final.empty() && arguments.path_to_file == "-") {
+        stream_with_5XX.open(arguments.file_final);
+    }
+    bool opened = Read_log(arguments, [&](const std::string &line, uint64_t offset) {
+        sampled_lines++;
+        Log_record record;
+        if (!arguments.format.Parse(line, record) || (!Failed(record) && arguments.anomalies == 0) ||
+            !Wanted(arguments, record)){
+            return;
+        }
+        time_t value_data = Converter_Time(std::string(record.local_time));
+        if (arguments.anomalies != 0 && arguments.from_time <= value_data && value_data <= arguments.to_time){
+            anomalies.Add(value_data, Failed(record));
+        }
+        if (Failed(record) && arguments.from_time <= value_data && value_data <= arguments.to_time){
+            if (arguments.print) {
+                std::cout << line << std::endl;
+            }
+            if (output) {
+                file_with_5XX.Add(offset, line.size() + 1);
+            }
+            else if (stream_with_5XX.is_open()) {
+                stream_with_5XX << line << '\n';
+            }
+            count_5XX++;
+            arguments.sample_lines ? squares_5XX++ : block_5XX++;
+            if (arguments.prefix_depth > 0){
+                prefixes.Add(Request_path(record.request));
+                return;
+            }
+            request = record.request;
+            if ((unsorted_5XX).find(request) != (unsorted_5XX).end()){
+                unsorted_5XX[request] = unsorted_5XX[request] + 1;
+            }
+            else{
+                unsorted_5XX[request] = 1;
+                counter += 1;
+                table_memory += request.size() + kMapNodeOverhead;
+                if (arguments.max_memory != 0 && table_memory > arguments.max_memory) {
+                    runs.push_back(Spill_run(unsorted_5XX));
+                    table_memory = 0;
+                }
+            } 
+        }
+    }, close_block);
+    close_block();
+    if (arguments.anomalies != 0) {
+        anomalies.Finish();
+    }
+    if (!opened) {
+        std::cerr << "Not open" << std::endl;
+    }
+    double sample = arguments.sample;
+    if (sample < 1 && sampled_lines == 0) {
+        std::cout << "Estimated 5XX requests: unknown, no part of the log was sampled (sample " << sample << ")"
+                  << std::endl;
+    }
+    else if (sample < 1 && count_5XX == 0 && arguments.sample_lines) {
+        // none seen: more than log(0.05) / log(1 - sample) would be missed less than 5% of the time
+        std::cout << "Estimated 5XX requests: 0, at most " << ceil(log(0.05) / log(1 - sample))
+                  << " (95% confidence, sample " << sample << ")" << std::endl;
+    }
+    else if (sample < 1 && count_5XX == 0) {
+        std::cout << "Estimated 5XX requests: 0 in the sampled blocks, no bound for the others (sample " << sample
+                  << ")" << std::endl;
+    }
+    else if (sample < 1) {
+        std::cout << "Estimated 5XX requests: " << llround(count_5XX / sample) << " +- "
+                  << llround(Sample_error(squares_5XX, sample)) << " (95% confidence, sample " << sample << ")"
+                  << std::endl;
+    }
+    n_stats_file.open(n_stats);
+    if (arguments.prefix_depth > 0){
+        unsorted_5XX = prefixes.Prefixes(arguments.prefix_depth);
+        std::cout << "Most popular n  prefix" << std::endl;
+        if (prefixes.truncated != 0){
+            std::cerr << "Path trie is full, " << prefixes.truncated
+                      << " requests were counted at a shorter prefix" << std::endl;
+        }
+    }
+    else {
+        std::cout << "Most popular n  request" << std::endl;
+    }
+    if (n_stats_file.is_open()){
+        for (auto &pair : Top_requests(unsorted_5XX, runs, arguments.n_stats)){
+            if (sample < 1) {
+                // Per-request intervals treat occurrences as independent, which is exact for line
+                // sampling and optimistic for requests clustered within a few blocks.
+                n_stats_file << pair.first << " " << llround(pair.second / sample) << " +- "
+                             << llround(Sample_error(pair.second, sample)) << std::endl;
+                std::cout << pair.first << " " << llround(pair.second / sample) << " +- "
+                          << llround(Sample_error(pair.second, sample)) << std::endl;
+                continue;
+            }
+            n_stats_file << pair.first << " " << pair.second << std::endl;
+            std::cout << pair.first << " " << pair.second << std::endl;
+        }
+    }
+    n_stats_file.close();
+}
+
+struct Window_peak {
+    time_t start = 0;
+    time_t end = 0;
+    size_t count = 0;
+};
+
+// Ranks windows: the busier first, the earlier first on ties. As a heap order its top is the
+// window ranked last.
+struct Busier {
+    bool operator()(const Window_peak &lhs, const Window_peak &rhs) const {
+        return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.start < rhs.start;
+    }
+};
+
+// The k busiest windows of which no two overlap: the busiest window, then the busiest one that does
+// not overlap it, and so on. Chosen windows are kept by start, so only the neighbours of a
+// candidate have to be checked.
+std::vector<Window_peak> Disjoint_peaks(std::vector<Window_peak> &windows, size_t k) {
+    std::sort(windows.begin(), windows.end(), Busier());
+    std::map<time_t, Window_peak> chosen;
+    std::vector<Window_peak> result;
+    for (auto &window : windows) {
+        if (result.size() == k) {
+            break;
+        }
+        auto next = chosen.lower_bound(window.start);
+        if ((next != chosen.end() && next->second.start <= window.end) ||
+            (next != chosen.begin() && std::prev(next)->second.end >= window.start)) {
+            continue;
+        }
+        chosen.emplace(window.start, window);
+        result.push_back(window);
+    }
+
+    return result;
+}
+
+void P_for_window(Arguments_for_prog & arguments) {
+    std::deque<time_t> mas;
+
+    size_t maximum_request = 0;
+    time_t left = arguments.from_time, right = arguments.to_time;
+    int time_limit = arguments.time;
+
+    // --peaks: windows [end - t, end] are taken one per second of log time, since a later line of
+    // the same second only makes the window busier. With one window per second a window overlaps
+    // at most 2t + 1 of them, so every window Disjoint_peaks picks ranks among the k (2t + 1)
+    // busiest, and only those are kept: memory follows --peaks and the window, not the log length.
+    size_t candidates = static_cast<size_t>(std::max(arguments.peaks, 0)) * (2 * static_cast<size_t>(time_limit) + 1);
+    std::priority_queue<Window_peak, std::vector<Window_peak>, Busier> windows;
+    Window_peak current;
+    auto keep = [&]() {
+        if (current.count == 0) {
+            return;
+        }
+        windows.push(current);
+        if (windows.size() > candidates) {
+            windows.pop();
+        }
+        current = Window_peak();
+    };
+
+    // Windows never span two sampled blocks, since the lines between them were not read.
+    bool opened = Read_log(arguments, [&](const std::string &line, uint64_t) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record) || !Wanted(arguments, record)){
+            return;
+        }
+        time_t conv_date = Converter_Time(std::string(record.local_time));
+
+        if (conv_date >= left && conv_date <= right) {
+            mas.push_back(conv_date);
+            while (mas.back() - mas.front() > time_limit) {
+                mas.pop_front();
+            }
+            maximum_request = std::max(maximum_request, mas.size());
+            if (arguments.peaks > 0) {
+                Window_peak window{conv_date - time_limit, conv_date, mas.size()};
+                if (current.end != window.end) {
+                    keep();
+                }
+                current = window;
+            }
+        }
+    }, [&]() {
+        mas.clear();
+        keep();
+    });
+    keep();
+
+    if (!opened) {
+        std::cerr << "Error opening file." << std::endl;
+        return;
+    }
+
+    std::cout << "File opened successfully." << std::endl;
+    double sample = arguments.sample;
+    if (sample == 1) {
+        std::cout << "Maximum request count: " << maximum_request << std::endl;
+    }
+    else if (arguments.sample_lines) {
+        // The maximum over many noisy windows overshoots the true peak, the more so the smaller the
+        // sample, so no interval is given for it.
+        std::cout << "Maximum request count: about " << llround(maximum_request / sample)
+                  << " (scaled from sample " << sample << ", biased upward)" << std::endl;
+    }
+    else {
+        std::cout << "Maximum request count: at least " << maximum_request << " (sampled blocks only)" << std::endl;
+    }
+    if (arguments.peaks > 0) {
+        std::cout << "Busiest windows" << std::endl;
+        std::vector<Window_peak> busiest;
+        for (; !windows.empty(); windows.pop()) {
+            busiest.push_back(windows.top());
+        }
+        for (auto &window : Disjoint_peaks(busiest, arguments.peaks)) {
+            std::cout << window.start << " - " << window.end << ": " << window.count << std::endl;
+        }
+    }
+}
+
+struct Session {
+    std::string client;
+    time_t first = 0;
+    time_t last = 0;
+    long long pages = 0;
+};
+
+// Bucket 0 holds 0, bucket b holds [2^(b - 1), 2^b - 1].
+int Log2_bucket(long long value) {
+    int bucket = 0;
+    while (value > 0) {
+        bucket++;
+        value >>= 1;
+    }
+
+    return bucket;
+}
+
+struct Session_stats {
+    long long sessions = 0;
+    long long pages = 0;
+    long long seconds = 0;
+    long long evicted = 0;
+    std::vector<long long> lengths = std::vector<long long>(64);
+    std::vector<long long> pages_per_session = std::vector<long long>(64);
+
+    void Close(const Session &session) {
+        sessions++;
+        pages += session.pages;
+        seconds += session.last - session.first;
+        lengths[Log2_bucket(session.last - session.first)]++;
+        pages_per_session[Log2_bucket(session.pages)]++;
+    }
+};
+
+void Print_histogram(const std::vector<long long> &histogram) {
+    for (size_t bucket = 0; bucket < histogram.size(); bucket++) {
+        if (histogram[bucket] == 0) {
+            continue;
+        }
+        long long low = bucket == 0 ? 0 : 1ll << (bucket - 1);
+        long long high = bucket == 0 ? 0 : (1ll << bucket) - 1;
+        std::cout << "  " << low << "-" << high << ": " << histogram[bucket] << std::endl;
+    }
+}
+
+// Sessions are split by --session-gap seconds of inactivity of a client. Open sessions are kept
+// in least-recently-seen order and closed as the log time moves past their gap, so memory follows
+// the number of concurrent clients rather than the size of the file. --sample does not apply:
+// dropped lines would split sessions, and split sessions cannot be scaled back.
+void P_for_sessions(Arguments_for_prog & arguments) {
+    Arguments_for_prog whole_log = arguments;
+    whole_log.sample = 1;
+    std::list<Session> open_sessions;
+    std::unordered_map<std::string_view, std::list<Session>::iterator> active;
+    Session_stats stats;
+    time_t now = 0;
+    time_t gap = arguments.session_gap;
+
+    auto close_oldest = [&]() {
+        stats.Close(open_sessions.back());
+        active.erase(open_sessions.back().client);
+        open_sessions.pop_back();
+    };
+
+    bool opened = Read_log(whole_log, [&](const std::string &line, uint64_t) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record) || !Wanted(arguments, record)){
+            return;
+        }
+        time_t conv_date = Converter_Time(std::string(record.local_time));
+        if (conv_date < arguments.from_time || conv_date > arguments.to_time) {
+            return;
+        }
+        now = std::max(now, conv_date);
+        while (!open_sessions.empty() && now - open_sessions.back().last > gap) {
+            close_oldest();
+        }
+
+        std::string_view client = record.remote_addr;
+        auto found = active.find(client);
+        if (found != active.end()) {
+            Session &session = *found->second;
+            session.last = std::max(session.last, conv_date);
+            session.pages++;
+            open_sessions.splice(open_sessions.begin(), open_sessions, found->second);
+            return;
+        }
+        if (active.size() >= kMaxActiveClients) {
+            close_oldest();
+            stats.evicted++;
+        }
+        open_sessions.push_front(Session{std::string(client), conv_date, conv_date, 1});
+        active.emplace(open_sessions.front().client, open_sessions.begin());
+    });
+    while (!open_sessions.empty()) {
+        close_oldest();
+    }
+
+    if (!opened) {
+        std::cerr << "Error opening file." << std::endl;
+        return;
+    }
+
+    std::cout << "Sessions: " << stats.sessions << " (gap " << gap << " s)" << std::endl;
+    if (stats.sessions == 0) {
+        return;
+    }
+    std::cout << "Average session length: " << static_cast<double>(stats.seconds) / stats.sessions
+              << " s, average pages per session: " << static_cast<double>(stats.pages) / stats.sessions
+              << std::endl;
+    std::cout << "Session length, s:" << std::endl;
+    Print_histogram(stats.lengths);
+    std::cout << "Pages per session:" << std::endl;
+    Print_histogram(stats.pages_per_session);
+    if (stats.evicted != 0) {
+        std::cerr << stats.evicted << " sessions were closed early to stay within "
+                  << kMaxActiveClients << " active clients" << std::endl;
+    }
+}
+
+// Top --stats failing requests over a window of --failing-window seconds, reported every
+// --failing-step seconds. Counts are kept for the current window only: a 5XX line is counted
+// once when it enters the window and uncounted when it leaves, and the ranking is updated along.
+// --sample does not apply, since the windows are often too sparse for a scaled count to mean much.
+void P_for_failing(Arguments_for_prog & arguments) {
+    Arguments_for_prog whole_log = arguments;
+    whole_log.sample = 1;
+    using Rank = std::pair<int, const std::string*>;
+    auto more_failing = [](const Rank &lhs, const Rank &rhs) {
+        return lhs.first != rhs.first ? lhs.first > rhs.first : *lhs.second < *rhs.second;
+    };
+    std::unordered_map<std::string, int> counts;
+    std::set<Rank, decltype(more_failing)> ranking(more_failing);
+    std::deque<std::pair<time_t, const std::string*>> window;
+    time_t length = arguments.failing_window, step = arguments.failing_step;
+    time_t end = 0;
+
+    auto change = [&](const std::string &request, int delta) {
+        auto found = counts.try_emplace(request, 0).first;
+        if (found->second != 0) {
+            ranking.erase(Rank(found->second, &found->first));
+        }
+        found->second += delta;
+        if (found->second == 0) {
+            counts.erase(found);
+            return static_cast<const std::string*>(nullptr);
+        }
+        ranking.emplace(found->second, &found->first);
+        return &found->first;
+    };
+    // Reports the window [end - length, end) and slides it by one step.
+    auto report = [&]() {
+        while (!window.empty() && window.front().first < end - length) {
+            change(*window.front().second, -1);
+            window.pop_front();
+        }
+        if (!ranking.empty()) {
+            std::cout << "[" << end - length << ", " << end << ")" << std::endl;
+            int left = arguments.n_stats;
+            for (auto it = ranking.begin(); it != ranking.end() && left != 0; ++it, --left) {
+                std::cout << "  " << *it->second << " " << it->first << std::endl;
+            }
+        }
+        end += step;
+    };
+
+    std::cout << "Most popular n  request by window" << std::endl;
+    bool opened = Read_log(whole_log, [&](const std::string &line, uint64_t) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record) || !Failed(record) || !Wanted(arguments, record)){
+            return;
+        }
+        time_t conv_date = Converter_Time(std::string(record.local_time));
+        if (conv_date < arguments.from_time || conv_date > arguments.to_time) {
+            return;
+        }
+        while (!window.empty() && conv_date >= end) {
+            report();
+        }
+        if (window.empty() && conv_date >= end) {
+            end = (conv_date / step + 1) * step;
+        }
+        window.emplace_back(conv_date, change(std::string(record.request), 1));
+    });
+    while (!window.empty()) {
+        report();
+    }
+
+    if (!opened) {
+        std::cerr << "Error opening file." << std::endl;
+    }
+}
+
+struct Rollup_minute {
+    time_t minute = 0;
+    long long status[5] = {};
+    long long bytes = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> failed;
+};
+
+// What a rollup was built from: the size and modification time of the log and a hash of its first
+// and last kStampBytes, so that a log rewritten to the same size is still noticed.
+struct Log_stamp {
+    uint64_t size = 0;
+    long long modified = 0;
+    uint64_t checksum = 0;
+
+    bool operator==(const Log_stamp &other) const = default;
+};
+
+Log_stamp Stamp_log(const std::string &path) {
+    Log_stamp stamp;
+    stamp.size = std::filesystem::file_size(path);
+    stamp.modified = std::filesystem::last_write_time(path).time_since_epoch().count();
+    std::ifstream log(path, std::ios::binary);
+    std::vector<char> buffer(std::min(stamp.size, kStampBytes));
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint64_t offset : {uint64_t(0), stamp.size - buffer.size()}) {
+        log.seekg(offset);
+        log.read(buffer.data(), buffer.size());
+        // FNV-1a
+        for (char c : buffer) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+    }
+    stamp.checksum = hash;
+
+    return stamp;
+}
+
+// Per-minute totals of a log: requests by status class, bytes sent and 5XX counts by request id.
+// Stored as text:
+//   AnalyzeLog rollup 2 <log size> <log modification time> <log checksum>
+//   <number of requests>, then one 5XX request per line, its id being its position
+//   <number of minutes>, then per line: <minute> <1XX> .. <5XX> <bytes> <k> <id> <count> (k pairs)
+struct Rollup {
+    Log_stamp log;
+    std::vector<std::string> requests;
+    std::vector<Rollup_minute> minutes;
+};
+
+bool Load_rollup(const std::string &path, const Log_stamp &log, Rollup &rollup) {
+    std::ifstream rollup_file(path);
+    std::string magic, kind;
+    int version = 0;
+    if (!(rollup_file >> magic >> kind >> version) || magic != "AnalyzeLog" || kind != "rollup" || version != 2 ||
+        !(rollup_file >> rollup.log.size >> rollup.log.modified >> rollup.log.checksum) || !(rollup.log == log)) {
+        return false;
+    }
+    size_t count = 0;
+    rollup_file >> count;
+    rollup_file.ignore(1);
+    rollup.requests.resize(count);
+    for (auto &request : rollup.requests) {
+        std::getline(rollup_file, request);
+    }
+    rollup_file >> count;
+    rollup.minutes.resize(count);
+    for (auto &minute : rollup.minutes) {
+        size_t failed = 0;
+        rollup_file >> minute.minute;
+        for (auto &status : minute.status) {
+            rollup_file >> status;
+        }
+        rollup_file >> minute.bytes >> failed;
+        minute.failed.resize(failed);
+        for (auto &pair : minute.failed) {
+            rollup_file >> pair.first >> pair.second;
+        }
+    }
+
+    return static_cast<bool>(rollup_file);
+}
+
+void Save_rollup(const std::string &path, const Rollup &rollup) {
+    std::ofstream rollup_file(path);
+    rollup_file << "AnalyzeLog rollup 2 " << rollup.log.size << ' ' << rollup.log.modified << ' ' << rollup.log.checksum
+                << '\n' << rollup.requests.size() << '\n';
+    for (auto &request : rollup.requests) {
+        rollup_file << request << '\n';
+    }
+    rollup_file << rollup.minutes.size() << '\n';
+    for (auto &minute : rollup.minutes) {
+        rollup_file << minute.minute;
+        for (auto status : minute.status) {
+            rollup_file << ' ' << status;
+        }
+        rollup_file << ' ' << minute.bytes << ' ' << minute.failed.size();
+        for (auto &pair : minute.failed) {
+            rollup_file << ' ' << pair.first << ' ' << pair.second;
+        }
+        rollup_file << '\n';
+    }
+}
+
+// One full pass over the log; --from, --to and --sample do not apply, the rollup covers everything.
+void Build_rollup(const Arguments_for_prog &arguments, const Log_stamp &log, Rollup &rollup) {
+    Arguments_for_prog whole_log = arguments;
+    whole_log.sample = 1;
+    whole_log.from_time = 0;
+    whole_log.to_time_flag = false;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::map<time_t, Rollup_minute> minutes;
+    std::map<time_t, std::map<uint32_t, uint32_t>> failed;
+
+    Read_log(whole_log, [&](const std::string &line, uint64_t) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record)){
+            return;
+        }
+        time_t minute = Converter_Time(std::string(record.local_time)) / 60 * 60;
+        char status = record.status.empty() ? ' ' : record.status[0];
+        Rollup_minute &totals = minutes[minute];
+        totals.minute = minute;
+        if (status >= '1' && status <= '5') {
+            totals.status[status - '1']++;
+        }
+        totals.bytes += atoll(std::string(record.bytes_send).c_str());
+        if (status == '5') {
+            auto id = ids.try_emplace(std::string(record.request), ids.size()).first;
+            failed[minute][id->second]++;
+        }
+    });
+
+    rollup.log = log;
+    rollup.requests.resize(ids.size());
+    for (auto &pair : ids) {
+        rollup.requests[pair.second] = pair.first;
+    }
+    for (auto &pair : minutes) {
+        auto &counts = failed[pair.first];
+        pair.second.failed.assign(counts.begin(), counts.end());
+        rollup.minutes.push_back(std::move(pair.second));
+    }
+}
+
+// Adds the lines with from <= time <= to to the rollup totals. Used for the minutes that --from and
+// --to cut, which only ever needs a seek and up to two minutes of the log.
+void Scan_minutes(const Arguments_for_prog &arguments, time_t from, time_t to, long long status[5], long long &bytes,
+                  std::map<std::string, int> &unsorted_5XX) {
+    Arguments_for_prog part = arguments;
+    part.sample = 1;
+    part.from_time = from;
+    part.to_time = to;
+    part.to_time_flag = true;
+    Read_log(part, [&](const std::string &line, uint64_t) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record)){
+            return;
+        }
+        time_t time = Converter_Time(std::string(record.local_time));
+        if (time < from || time > to) {
+            return;
+        }
+        char status_class = record.status.empty() ? ' ' : record.status[0];
+        if (status_class >= '1' && status_class <= '5') {
+            status[status_class - '1']++;
+        }
+        bytes += atoll(std::string(record.bytes_send).c_str());
+        if (status_class == '5') {
+            unsorted_5XX[std::string(record.request)]++;
+        }
+    });
+}
+
+// Answers --stats and --window from the rollup in time proportional to the number of minutes.
+// Minutes that lie wholly within --from and --to come from the rollup and the cut minutes at either
+// end from the log, so --stats matches the full scan. The window answer is the busiest run of
+// t / 60 whole minutes, which is not the sliding maximum and is printed as such.
+void P_for_rollup(Arguments_for_prog & arguments, bool stats, bool window) {
+    Rollup rollup;
+    if (!std::filesystem::exists(arguments.path_to_file)) {
+        std::cerr << "Error opening file." << std::endl;
+        return;
+    }
+    Log_stamp log = Stamp_log(arguments.path_to_file);
+    if (!Load_rollup(arguments.rollup_file, log, rollup)) {
+        rollup = Rollup();
+        Build_rollup(arguments, log, rollup);
+        Save_rollup(arguments.rollup_file, rollup);
+    }
+
+    time_t from = arguments.from_time, to = arguments.to_time;
+    // whole minutes start in [whole_begin, whole_end)
+    time_t whole_begin = (from + 59) / 60 * 60;
+    time_t whole_end = to == std::numeric_limits<time_t>::max() ? to : (to + 1) / 60 * 60;
+    long long status[5] = {};
+    long long bytes = 0;
+    std::map<std::string, int> unsorted_5XX;
+    if (whole_begin >= whole_end) {
+        Scan_minutes(arguments, from, to, status, bytes, unsorted_5XX);
+        whole_begin = whole_end = from;
+    }
+    else {
+        if (from < whole_begin) {
+            Scan_minutes(arguments, from, whole_begin - 1, status, bytes, unsorted_5XX);
+        }
+        if (whole_end <= to) {
+            Scan_minutes(arguments, whole_end, to, status, bytes, unsorted_5XX);
+        }
+    }
+
+    auto first = std::lower_bound(rollup.minutes.begin(), rollup.minutes.end(), whole_begin,
+                                  [](const Rollup_minute &minute, time_t time) { return minute.minute < time; });
+    auto last = std::lower_bound(first, rollup.minutes.end(), whole_end,
+                                 [](const Rollup_minute &minute, time_t time) { return minute.minute < time; });
+    for (auto minute = first; minute != last; ++minute) {
+        for (int i = 0; i < 5; i++) {
+            status[i] += minute->status[i];
+        }
+        bytes += minute->bytes;
+        if (stats) {
+            for (auto &pair : minute->failed) {
+                unsorted_5XX[rollup.requests[pair.first]] += pair.second;
+            }
+        }
+    }
+
+    std::cout << "Requests by status:";
+    for (int i = 0; i < 5; i++) {
+        std::cout << " " << i + 1 << "XX " << status[i];
+    }
+    std::cout << ", bytes " << bytes << std::endl;
+    if (stats) {
+        std::vector<std::filesystem::path> runs;
+        std::ofstream n_stats_file("stats.txt");
+        std::cout << "Most popular n  request" << std::endl;
+        for (auto &pair : Top_requests(unsorted_5XX, runs, arguments.n_stats)){
+            n_stats_file << pair.first << " " << pair.second << std::endl;
+            std::cout << pair.first << " " << pair.second << std::endl;
+        }
+    }
+    if (window) {
+        long long maximum_request = 0, counter = 0;
+        auto left = first;
+        for (auto right = first; right != last; ++right) {
+            counter += std::accumulate(right->status, right->status + 5, 0ll);
+            while (right->minute - left->minute >= arguments.time) {
+                counter -= std::accumulate(left->status, left->status + 5, 0ll);
+                ++left;
+            }
+            maximum_request = std::max(maximum_request, counter);
+        }
+        std::cout << "Maximum request count in " << arguments.time / 60 << " whole minutes: " << maximum_request
+                  << std::endl;
+    }
+}
+
+// Logs loaded once for --serve. Every request only adds to a count per second of log time, kept
+// with running totals so that a range is answered by two binary searches; the 5XX requests are
+// also kept as rows (time, request id) sorted by time, which is all that top has to look at.
+struct Log_index {
+    std::vector<time_t> times;
+    std::vector<time_t> seconds;
+    // requests and 5XX requests in seconds[0] .. seconds[i - 1]
+    std::vector<uint64_t> total_before;
+    std::vector<uint64_t> failed_before;
+    std::vector<std::pair<time_t, uint32_t>> failed;
+    std::vector<std::string> requests;
+    std::unordered_map<std::string, uint32_t> dictionary;
+    std::vector<uint32_t> scratch;
+
+    void Add(const Arguments_for_prog &arguments, const std::string &line) {
+        Log_record record;
+        if (!arguments.format.Parse(line, record) || !Wanted(arguments, record)){
+            return;
+        }
+        time_t time = Converter_Time(std::string(record.local_time));
+        times.push_back(time);
+        if (!Failed(record)) {
+            return;
+        }
+        auto id = dictionary.try_emplace(std::string(record.request), requests.size());
+        if (id.second) {
+            requests.push_back(id.first->first);
+        }
+        failed.emplace_back(time, id.first->second);
+    }
+
+    // Logs are almost sorted already, so the sorts are cheap.
+    void Sort() {
+        std::sort(times.begin(), times.end());
+        std::stable_sort(failed.begin(), failed.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.first < rhs.first;
+        });
+        total_before.push_back(0);
+        failed_before.push_back(0);
+        for (size_t i = 0, j = 0; i < times.size();) {
+            time_t second = times[i];
+            uint64_t failed_count = 0;
+            for (; i < times.size() && times[i] == second; i++) {
+            }
+            for (; j < failed.size() && failed[j].first == second; j++) {
+                failed_count++;
+            }
+            seconds.push_back(second);
+            total_before.push_back(i);
+            failed_before.push_back(failed_before.back() + failed_count);
+        }
+        times = std::vector<time_t>();
+        dictionary.clear();
+        scratch.assign(requests.size(), 0);
+    }
+
+    size_t Requests() const {
+        return total_before.back();
+    }
+
+    // Seconds with from <= second <= to.
+    std::pair<size_t, size_t> Range(time_t from, time_t to) const {
+        return {std::lower_bound(seconds.begin(), seconds.end(), from) - seconds.begin(),
+                std::upper_bound(seconds.begin(), seconds.end(), to) - seconds.begin()};
+    }
+
+    // The n most frequent 5XX requests in [from, to], most frequent first, ties by the request;
+    // all of them if n is negative.
+    std::vector<std::pair<std::string, int>> Top(long long n, time_t from, time_t to) {
+        auto first = std::lower_bound(failed.begin(), failed.end(), std::make_pair(from, uint32_t(0)));
+        std::vector<uint32_t> touched;
+        for (auto row = first; row != failed.end() && row->first <= to; ++row) {
+            if (scratch[row->second]++ == 0) {
+                touched.push_back(row->second);
+            }
+        }
+        auto more_failing = [this](uint32_t lhs, uint32_t rhs) {
+            return scratch[lhs] != scratch[rhs] ? scratch[lhs] > scratch[rhs] : requests[lhs] < requests[rhs];
+        };
+        size_t count = n < 0 ? touched.size() : std::min<size_t>(n, touched.size());
+        std::partial_sort(touched.begin(), touched.begin() + count, touched.end(), more_failing);
+
+        std::vector<std::pair<std::string, int>> result;
+        for (size_t i = 0; i < count; i++) {
+            result.emplace_back(requests[touched[i]], scratch[touched[i]]);
+        }
+        for (uint32_t id : touched) {
+            scratch[id] = 0;
+        }
+        return result;
+    }
+};
+
+// Answers one query per line of stdin, each answer being closed by a line "end":
+//   top <n> [from to]     the n most frequent 5XX requests
+//   window <t> [from to]  the maximum number of requests within t seconds
+//   count [from to]       the number of requests and of 5XX requests
+//   quit
+void Serve(Arguments_for_prog & arguments) {
+    Log_index index;
+    for (auto &path : arguments.log_files) {
+        Arguments_for_prog log = arguments;
+        log.path_to_file = path;
+        log.sample = 1;
+        log.from_time = 0;
+        log.to_time_flag = false;
+        if (!Read_log(log, [&](const std::string &line, uint64_t) { index.Add(arguments, line); })) {
+            std::cerr << "Error opening file " << path << std::endl;
+        }
+    }
+    index.Sort();
+    std::cout << "Loaded " << index.Requests() << " requests" << std::endl;
+
+    std::string query;
+    while (std::getline(std::cin, query)) {
+        std::istringstream words(query);
+        std::string command;
+        long long value = 0;
+        time_t from = arguments.from_time, to = arguments.to_time;
+        words >> command;
+        if (command == "quit") {
+            break;
+        }
+        if (command != "count") {
+            words >> value;
+        }
+        words >> from >> to;
+        auto [first, last] = index.Range(from, to);
+
+        if (command == "top") {
+            for (auto &pair : index.Top(value, from, to)) {
+                std::cout << pair.first << " " << pair.second << '\n';
+            }
+        }
+        else if (command == "window") {
+            // the busiest window ends on a second with requests
+            uint64_t maximum_request = 0;
+            for (size_t left = first, right = first; right < last; right++) {
+                while (index.seconds[right] - index.seconds[left] > value) {
+                    left++;
+                }
+                maximum_request = std::max(maximum_request, index.total_before[right + 1] - index.total_before[left]);
+            }
+            std::cout << maximum_request << '\n';
+        }
+        else if (command == "count") {
+            std::cout << index.total_before[last] - index.total_before[first] << " "
+                      << index.failed_before[last] - index.failed_before[first] << '\n';
+        }
+        else {
+            std::cout << "error: unknown query " << command << '\n';
+        }
+        std::cout << "end" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Arguments_for_prog args;
+    if (!Parsing_arg(args, argc, argv)) {
+        return 1;
+    }
+    if (args.serve){
+        Serve(args);
+        return 0;
+    }
+    // The rollup has no lines to export, so --output and --print still need a pass over the log.
+    // It covers all clients, so address filters do too, and it is exact and keeps whole requests,
+    // so --sample and --prefix-depth do as well.
+    bool rollup = !args.rollup_file.empty() && args.include_ips.Empty() && args.exclude_ips.Empty() &&
+                  args.sample == 1;
+    bool rollup_stats = rollup && args.file_final.empty() && !args.print && args.anomalies == 0 &&
+                        args.prefix_depth == 0;
+    bool rollup_window = rollup && args.time != 0 && args.time % 60 == 0 && args.peaks == 0;
+    if (rollup_stats || rollup_window){
+        P_for_rollup(args, rollup_stats, rollup_window);
+    }
+    if (args.path_to_file != "" && !rollup_stats){
+        Parser(args);
+    }
+    if (args.time != 0 && !rollup_window){
+        P_for_window(args);
+    }
+    if (args.session_gap != 0){
+        P_for_sessions(args);
+    }
+    if (args.failing_window != 0){
+        P_for_failing(args);
     }
     return 0;
 }
@@ -0,0 +1,253 @@
+#pragma once
+#include "number.h"
+#include <optional>
+#include <stdexcept>
+
+
+// Precomputed Montgomery constants for one odd modulus, R = 2^(64 * limb count).
+template <int Bits>
+struct itmo_montgomery {
+    using Value = typename itmo_detail::Layout<Bits>::Value;
+
+    Value modulus;
+    uint64_t inverse;  // -modulus^-1 mod 2^64
+    Value r_mod;       // R mod modulus, the Montgomery form of 1
+    Value r2_mod;      // R^2 mod modulus, converts into Montgomery form
+};
+
+using uint239_montgomery_t = itmo_montgomery<239>;
+
+// Throws std::invalid_argument for an even modulus; only the modulus value is used, not its shift.
+template <int Bits>
+constexpr itmo_montgomery<Bits> MakeMontgomery(const itmo_uint<Bits>& modulus);
+
+// The results carry shifts as if built from operator*: ModMul adds the shifts, ModPow multiplies the base
+// shift by the exponent, ModInverse negates it.
+template <int Bits>
+constexpr itmo_uint<Bits> ModMul(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs, const itmo_montgomery<Bits>& context);
+
+template <int Bits>
+constexpr itmo_uint<Bits> ModPow(const itmo_uint<Bits>& base, const itmo_uint<Bits>& exponent, const itmo_montgomery<Bits>& context);
+
+// Empty when value and the modulus are not coprime.
+template <int Bits>
+constexpr std::optional<itmo_uint<Bits>> ModInverse(const itmo_uint<Bits>& value, const itmo_montgomery<Bits>& context);
+
+
+namespace itmo_detail {
+
+// value mod modulus for a value of any limb count.
+template <int N, int M>
+constexpr Limbs<M> Reduce(const Limbs<N>& value, const Limbs<M>& modulus) {
+    Limbs<N> wide_modulus{};
+    for (int i = 0; i < M; i++) {
+        wide_modulus.limb[i] = modulus.limb[i];
+    }
+    Limbs<N> quotient{};
+    Limbs<N> remainder{};
+    DivLimbs(value, wide_modulus, quotient, remainder);
+
+    Limbs<M> result{};
+    for (int i = 0; i < M; i++) {
+        result.limb[i] = remainder.limb[i];
+    }
+    return result;
+}
+
+// lhs * rhs * R^-1 mod modulus (CIOS). Needs lhs < modulus; rhs may be anything below R.
+template <int Bits>
+constexpr typename Layout<Bits>::Value MontMul(const typename Layout<Bits>::Value& lhs, const typename Layout<Bits>::Value& rhs,
+                                               const itmo_montgomery<Bits>& context) {
+    constexpr int N = Layout<Bits>::kLimbCount;
+    const uint64_t* modulus = context.modulus.limb;
+    uint64_t t[N + 2] = {};
+
+    for (int i = 0; i < N; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < N; j++) {
+            uint64_t high;
+            uint64_t low;
+            MulWord(lhs.limb[j], rhs.limb[i], high, low);
+            low += carry;
+            high += low < carry;
+            t[j] += low;
+            high += t[j] < low;
+            carry = high;
+        }
+        t[N] += carry;
+        t[N + 1] = t[N] < carry;
+
+        uint64_t factor = t[0] * context.inverse;
+        uint64_t high;
+        uint64_t low;
+        MulWord(factor, modulus[0], high, low);
+        low += t[0];
+        carry = high + (low < t[0]);
+        for (int j = 1; j < N; j++) {
+            MulWord(factor, modulus[j], high, low);
+            low += carry;
+            high += low < carry;
+            low += t[j];
+            high += low < t[j];
+            t[j - 1] = low;
+            carry = high;
+        }
+        t[N - 1] = t[N] + carry;
+        t[N] = t[N + 1] + (t[N - 1] < carry);
+    }
+
+    Limbs<N> result{};
+    for (int i = 0; i < N; i++) {
+        result.limb[i] = t[i];
+    }
+    if (t[N] != 0 || Compare(result, context.modulus) >= 0) {
+        result = Sub(result, context.modulus);
+    }
+    return result;
+}
+
+// x / 2 mod an odd modulus; x + modulus may need one bit more than the limbs hold.
+template <int N>
+constexpr Limbs<N> HalfMod(const Limbs<N>& value, const Limbs<N>& modulus) {
+    if ((value.limb[0] & 1) == 0) {
+        return ShiftRight(value, 1);
+    }
+    Limbs<N> sum = Add(value, modulus);
+    bool carry = Compare(sum, value) < 0;
+    sum = ShiftRight(sum, 1);
+    sum.limb[N - 1] |= static_cast<uint64_t>(carry) << 63;
+    return sum;
+}
+
+template <int N>
+constexpr Limbs<N> SubMod(const Limbs<N>& lhs, const Limbs<N>& rhs, const Limbs<N>& modulus) {
+    Limbs<N> diff = Sub(lhs, rhs);
+    return Compare(lhs, rhs) >= 0 ? diff : Add(diff, modulus);
+}
+
+template <int N>
+constexpr bool IsOne(const Limbs<N>& value) {
+    return BitLength(value) == 1;
+}
+
+} // namespace itmo_detail
+
+template <int Bits>
+constexpr itmo_montgomery<Bits> MakeMontgomery(const itmo_uint<Bits>& modulus) {
+    using L = itmo_detail::Layout<Bits>;
+    constexpr int N = L::kLimbCount;
+    itmo_montgomery<Bits> context{};
+    context.modulus = Decode(modulus).limbs;
+    if ((context.modulus.limb[0] & 1) == 0) {
+        throw std::invalid_argument("MakeMontgomery: modulus must be odd");
+    }
+
+    // Newton iteration doubles the correct low bits of the inverse: 3 (m * m = 1 mod 8), 6, 12, 24, 48, 96.
+    uint64_t inverse = context.modulus.limb[0];
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - context.modulus.limb[0] * inverse;
+    }
+    context.inverse = 0 - inverse;
+
+    itmo_detail::Limbs<N + 1> r{};
+    r.limb[N] = 1;
+    context.r_mod = itmo_detail::Reduce(r, context.modulus);
+    context.r2_mod = itmo_detail::Reduce(itmo_detail::MulLimbs<2 * N>(context.r_mod, context.r_mod), context.modulus);
+    return context;
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> ModMul(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs, const itmo_montgomery<Bits>& context) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> left = Decode(lhs);
+    itmo_value<Bits> right = Decode(rhs);
+
+    // (lhs * R^2 * R^-1) is lhs in Montgomery form, below the modulus; one more product drops the R again.
+    typename L::Value product = itmo_detail::MontMul<Bits>(itmo_detail::MontMul<Bits>(context.r2_mod, left.limbs, context), right.limbs, context);
+    return Encode(itmo_value<Bits>{product, (left.shift + right.shift) & L::kShiftMask});
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> ModPow(const itmo_uint<Bits>& base, const itmo_uint<Bits>& exponent, const itmo_montgomery<Bits>& context) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> value = Decode(base);
+    typename L::Value power = Decode(exponent).limbs;
+    int bits = itmo_detail::BitLength(power);
+    auto bit = [&power](int index) -> uint64_t {
+        return (power.limb[index / 64] >> (index % 64)) & 1;
+    };
+
+    // Window width grows with the exponent; odd powers base^1, base^3, ... are precomputed.
+    const int kMaxWindow = 5;
+    int window = bits > 160 ? 5 : bits > 48 ? 4 : bits > 12 ? 3 : 1;
+    typename L::Value odd_powers[1 << (kMaxWindow - 1)]{};
+    odd_powers[0] = itmo_detail::MontMul<Bits>(context.r2_mod, value.limbs, context);
+    typename L::Value square = itmo_detail::MontMul<Bits>(odd_powers[0], odd_powers[0], context);
+    for (int i = 1; i < (1 << (window - 1)); i++) {
+        odd_powers[i] = itmo_detail::MontMul<Bits>(odd_powers[i - 1], square, context);
+    }
+
+    typename L::Value result = context.r_mod;
+    for (int i = bits - 1; i >= 0;) {
+        if (bit(i) == 0) {
+            result = itmo_detail::MontMul<Bits>(result, result, context);
+            i--;
+            continue;
+        }
+        // Longest window [low, i] of at most `window` bits that ends in a set bit.
+        int low = i - window + 1 < 0 ? 0 : i - window + 1;
+        while (bit(low) == 0) {
+            low++;
+        }
+        uint64_t digit = 0;
+        for (int j = i; j >= low; j--) {
+            digit = (digit << 1) | bit(j);
+            result = itmo_detail::MontMul<Bits>(result, result, context);
+        }
+        result = itmo_detail::MontMul<Bits>(result, odd_powers[digit / 2], context);
+        i = low - 1;
+    }
+
+    typename L::Value one{};
+    one.limb[0] = 1;
+    result = itmo_detail::MontMul<Bits>(result, one, context);
+    return Encode(itmo_value<Bits>{result, (value.shift * power.limb[0]) & L::kShiftMask});
+}
+
+template <int Bits>
+constexpr std::optional<itmo_uint<Bits>> ModInverse(const itmo_uint<Bits>& value, const itmo_montgomery<Bits>& context) {
+    using L = itmo_detail::Layout<Bits>;
+    const typename L::Value& modulus = context.modulus;
+    itmo_value<Bits> number = Decode(value);
+
+    // Binary extended Euclid: u = x1 * value and v = x2 * value (mod modulus) hold throughout.
+    typename L::Value u = itmo_detail::Reduce(number.limbs, modulus);
+    typename L::Value v = modulus;
+    typename L::Value x1{};
+    typename L::Value x2{};
+    x1.limb[0] = 1;
+
+    while (!itmo_detail::IsOne(u) && !itmo_detail::IsOne(v)) {
+        if (itmo_detail::BitLength(u) == 0 || itmo_detail::BitLength(v) == 0) {
+            return std::nullopt;
+        }
+        while ((u.limb[0] & 1) == 0) {
+            u = itmo_detail::ShiftRight(u, 1);
+            x1 = itmo_detail::HalfMod(x1, modulus);
+        }
+        while ((v.limb[0] & 1) == 0) {
+            v = itmo_detail::ShiftRight(v, 1);
+            x2 = itmo_detail::HalfMod(x2, modulus);
+        }
+        if (itmo_detail::Compare(u, v) >= 0) {
+            u = itmo_detail::Sub(u, v);
+            x1 = itmo_detail::SubMod(x1, x2, modulus);
+        } else {
+            v = itmo_detail::Sub(v, u);
+            x2 = itmo_detail::SubMod(x2, x1, modulus);
+        }
+    }
+
+    typename L::Value inverse = itmo_detail::Reduce(itmo_detail::IsOne(u) ? x1 : x2, modulus);
+    return Encode(itmo_value<Bits>{inverse, (0 - number.shift) & L::kShiftMask});
+}
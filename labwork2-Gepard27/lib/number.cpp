@@ -1,242 +1,98 @@
 #include "number.h"
 #include <cstring>
 
-uint239_t FromInt(uint32_t value, uint32_t shift) {
-    
-    uint239_t val;
-
-    for (int i = 34; i >= 0; i--) {
-        val.data[i] = value % 128;
-        value /= 128;
-    }
-    
-    return ShiftFront(val, shift);
-}
-
-uint239_t ShiftNumber(uint239_t number, uint32_t c_shift) {
-    bool flag = false;
-    c_shift %= 7 * 35;
-    for (int i = c_shift; i > 0; i--) {
-        for (int j = 34; j >= 0; j--) {
-            number.data[j] = (number.data[j] << 1);
-
-            if (flag) {
-                number.data[j] += 1;
-            }
-
-            if ((number.data[j] >> 7) == 1) {
-                number.data[j] -= 128;
-                flag = true;
-            }
-            else {
-                flag = false;
-            }
-        }
-
-        if (flag) {
-            number.data[34] += 1;
-            flag = false;
-        }
-    }
-    return number;    
-}
-
-uint239_t FromString(const char* str, uint32_t shift) { 
-    uint239_t number = FromInt(0,0);
-
-    for (int i = 0; i < strlen(str) - 1; i++) {  
-        number = number + FromInt(str[i] - '0', 0);
-        number = number * FromInt(10,0); 
-    }
-    number = number + FromInt(str[strlen(str) - 1] - '0', 0);
-
-    return ShiftFront(number, shift); 
-}
-
-uint239_t ShiftBack(uint239_t number, uint32_t shift) {
-    for (int i = 0; i < 35; i++) { 
-        if ((number.data[i] >> 7) == 1) { 
-            number.data[i] -= 128; 
-        } 
-    }
-
-    return ShiftNumber(number, (7 * 35 - (shift % (7 * 35))));  
-}
-
-uint239_t ShiftFront(uint239_t number, uint32_t shift) {
-    uint239_t sum_num = ShiftNumber(number, shift);
-
-    int i = 34;
-    while (shift > 0) {
-        if (shift % 2 == 1) {
-            sum_num.data[i] += 128;
-        }
-        shift /= 2;
-        i -= 1;
-    }
-    return sum_num; 
-}
-
-
-uint239_t operator+(const uint239_t& lhs, const uint239_t& rhs) {
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
- 
-    uint239_t sum_num{};
-    uint8_t ost = 0;
-
-    for (int i = 34; i >= 0; i--) {
-        sum_num.data[i] += (num_1.data[i] + num_2.data[i] + ost) % 128;
-        ost = (num_1.data[i] + num_2.data[i] + ost) / 128;
-    }
-
-    return ShiftFront(sum_num, GetShift(lhs) + GetShift(rhs));
-}
-
-
-
-uint239_t operator-(const uint239_t& lhs, const uint239_t& rhs) {
-    bool flag = false;
-
-    uint32_t shift;
-    if (GetShift(lhs) >= GetShift(rhs)) {
-        shift = GetShift(lhs) - GetShift(rhs);
-    } else {
-        shift = (1ll << 35) + GetShift(lhs) - GetShift(rhs); 
+using namespace itmo_detail;
+
+namespace {
+
+const uint64_t kTenPow19 = 10000000000000000000ull;
+// floor((2^128 - 1) / 10^19) - 2^64; 10^19 already has its top bit set.
+const uint64_t kTenPow19Inverse = 0xd83c94fb6d2ac34aull;
+const int kChunkDigits = 19;
+
+// (high:low) / 10^19 for high < 10^19 by multiplying with the precomputed reciprocal.
+uint64_t DivTenPow19(uint64_t high, uint64_t low, uint64_t& rest) {
+    uint64_t quotient;
+    uint64_t quotient_low;
+    MulWord(kTenPow19Inverse, high, quotient, quotient_low);
+    quotient_low += low;
+    quotient += high + (quotient_low < low) + 1;
+
+    rest = low - quotient * kTenPow19;
+    if (rest > quotient_low) {
+        quotient--;
+        rest += kTenPow19;
     }
-
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
-   
-    uint239_t num_sub = num_1;
-
-    for (int i = 34; i >= 0; i--) {
-        if (flag == true && num_sub.data[i] > 0) {
-            num_sub.data[i] -= 1;
-            flag = false;
-        } else if (flag == true) {
-            num_sub.data[i] += 127;
-            flag = true;
-        }
-
-        if (num_sub.data[i] >= num_2.data[i]) {
-            num_sub.data[i] -= num_2.data[i];
-        } else {
-            num_sub.data[i] += (128 - num_2.data[i]);
-            flag = true;
-        }
-    }
-   
-    return ShiftFront(num_sub, shift);
-}
-
-uint239_t operator*(const uint239_t& lhs, const uint239_t& rhs) {
-    uint32_t shift = GetShift(lhs) + GetShift(rhs);
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
-    uint239_t num_mult{};
-    uint32_t mult_shift = 0;
-
-
-    for (int i = 34; i >= 0; i--) {
-        int number = num_2.data[i]; 
-        int massive_bit[8];
-
-        for (int j = 7; j >= 0; j--){
-            massive_bit[j] = number % 2;
-            number /= 2;
-        }
-
-        for (int s = 7; s > 0; s--){
-            if (massive_bit[s] == 1) {
-                num_mult = num_mult + ShiftNumber(num_1, mult_shift);
-            }
-            mult_shift += 1;
-        }  
+    if (rest >= kTenPow19) {
+        quotient++;
+        rest -= kTenPow19;
     }
-    
-    return ShiftFront(num_mult, shift);
+    return quotient;
 }
 
-uint239_t operator/(const uint239_t& lhs, const uint239_t& rhs) {
-    uint32_t shift = 0;
-    if (GetShift(lhs) >= GetShift(rhs)) {
-        shift = GetShift(lhs) - GetShift(rhs);
-    } else {
-        shift = (1ll << 35) + GetShift(lhs) - GetShift(rhs); 
-    }
-
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
-   
-    uint239_t num_div = FromInt(0,0);
-
-    if (num_2 == FromInt(1,0)) {
-        num_div = num_1;
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the last `count` decimal digits of value right-aligned before `end`, two per step.
+void WriteDigits(char* end, uint64_t value, int count) {
+    for (; count >= 2; count -= 2) {
+        end -= 2;
+        std::memcpy(end, kDigitPairs + 2 * (value % 100), 2);
+        value /= 100;
     }
-    else {
-        while (num_1 >= num_2) {
-            num_1 = num_1 - num_2;
-            num_div = num_div + FromInt(1, 0);
-        } 
+    if (count == 1) {
+        *(end - 1) = '0' + value % 10;
     }
-
-    return ShiftFront(num_div, shift);
-    
 }
 
-
-bool operator==(const uint239_t& lhs, const uint239_t& rhs) {
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
-    for (int i = 0; i < 35; i++) {
-        if (num_1.data[i] != num_2.data[i]) {
-            return false;
-        } 
+int DigitCount(uint64_t value) {
+    int count = 1;
+    while (value >= 10) {
+        value /= 10;
+        count++;
     }
-    return true;
+    return count;
 }
 
-bool operator!=(const uint239_t& lhs, const uint239_t& rhs) {
-    return !(lhs == rhs);
-}
+} // namespace
 
-bool operator>=(const uint239_t& lhs, const uint239_t& rhs) {
-    uint239_t num_1 = ShiftBack(lhs, GetShift(lhs));
-    uint239_t num_2 = ShiftBack(rhs, GetShift(rhs));
+template <int Bits>
+std::string ToString(const itmo_uint<Bits>& value) {
+    using L = Layout<Bits>;
+    typename L::Value number = ToLimbs(value);
 
-    for (int i = 0; i < 35; i++) {
-        if (num_1.data[i] > num_2.data[i]) {
-            return true;
-        } else if (num_1.data[i] < num_2.data[i]) {
-            return false;
+    // 10^19 > 2^63, so every limb adds at most one base-10^19 chunk (plus one for the remainder).
+    uint64_t chunks[L::kLimbCount + 1];
+    int chunk_count = 0;
+    do {
+        uint64_t rest = 0;
+        for (int i = L::kLimbCount - 1; i >= 0; i--) {
+            number.limb[i] = DivTenPow19(rest, number.limb[i], rest);
         }
+        chunks[chunk_count++] = rest;
+    } while (BitLength(number) != 0);
+
+    int top_digits = DigitCount(chunks[chunk_count - 1]);
+    std::string result(top_digits + (chunk_count - 1) * kChunkDigits, '0');
+    char* end = result.data() + result.size();
+    for (int i = 0; i < chunk_count - 1; i++) {
+        WriteDigits(end, chunks[i], kChunkDigits);
+        end -= kChunkDigits;
     }
-    return true;
-}
+    WriteDigits(end, chunks[chunk_count - 1], top_digits);
 
-std::ostream& operator<<(std::ostream& stream, const uint239_t& value) { 
-    for (int i = 0; i <= 34; i++) { 
-        int number = value.data[i]; 
-        int massive_bit[8];
-        for (int j = 7; j >= 0; j--){
-            massive_bit[j] = number % 2;
-            number /= 2;
-        }
-        for (int s = 0; s < 8; s++){
-            stream << massive_bit[s]; 
-        } 
-    } 
-    return stream; 
+    return result;
 }
 
-uint64_t GetShift(const uint239_t& value) {
-    uint239_t number = value;
-    uint32_t shift = 0;
-    for (int i = 34; i >= 0; i--) {
-        shift += (number.data[i] >> 7) * (1ll << (34 - i));
-    }
-    return shift;
-}
-
-
+template std::string ToString(const uint127_t& value);
+template std::string ToString(const uint239_t& value);
+template std::string ToString(const uint511_t& value);
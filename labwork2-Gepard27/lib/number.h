@@ -1,39 +1,674 @@
 #pragma once
+#include <bit>
+#include <charconv>
 #include <cinttypes>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 
-struct uint239_t {
-    uint8_t data[35];
+// ITMO Endian unsigned integer of Bits value bits: every byte holds 7 payload bits and one
+// service bit, the service bits store the circular shift of the payload.
+template <int Bits>
+struct itmo_uint {
+    static constexpr int kBits = Bits;
+    static constexpr int kBytes = (Bits + 6) / 7;
+
+    uint8_t data[kBytes];
 };
 
+using uint127_t = itmo_uint<127>;
+using uint239_t = itmo_uint<239>;
+using uint511_t = itmo_uint<511>;
+
 static_assert(sizeof(uint239_t) == 35, "Size of uint239_t must be no higher than 35 bytes");
 
-uint239_t ShiftNumber(uint239_t num, uint32_t c_shift);
+// Full product of two values: high * 2^Bits + low, both halves carry the product's shift.
+template <int Bits>
+struct itmo_uint_wide {
+    itmo_uint<Bits> high;
+    itmo_uint<Bits> low;
+};
+
+// Quotient and remainder of one division, both with the quotient's shift.
+template <int Bits>
+struct itmo_uint_div {
+    itmo_uint<Bits> quot;
+    itmo_uint<Bits> rem;
+};
+
+using uint478_t = itmo_uint_wide<239>;
+using uint239_div_t = itmo_uint_div<239>;
+
+// Shifts are kept modulo 2^kBytes (modulo 2^64 for types wider than 64 bytes).
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftNumber(itmo_uint<Bits> num, uint32_t c_shift);
+
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftBack(itmo_uint<Bits> num, uint64_t shift);
+
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftFront(itmo_uint<Bits> num, uint64_t shift);
+
+template <typename T>
+constexpr T FromInt(uint32_t value, uint64_t shift);
+
+constexpr uint239_t FromInt(uint32_t value, uint32_t shift);
+
+// Throws std::invalid_argument unless str is all decimal digits, std::out_of_range if the value is 2^Bits or more.
+template <typename T>
+constexpr T FromString(const char* str, uint64_t shift);
+
+constexpr uint239_t FromString(const char* str, uint32_t shift);
+
+// Parses the leading decimal digits of [first, last) like std::from_chars; value is left untouched on error.
+template <int Bits>
+constexpr std::from_chars_result FromChars(const char* first, const char* last, itmo_uint<Bits>& value, uint64_t shift);
+
+template <int Bits>
+constexpr itmo_uint<Bits> operator+(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint<Bits> operator-(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint<Bits> operator*(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint_wide<Bits> MulWide(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint<Bits> operator/(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint<Bits> operator%(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr itmo_uint_div<Bits> DivMod(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr bool operator==(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr bool operator!=(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+template <int Bits>
+constexpr bool operator>=(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs);
+
+// Defined in number.cpp for uint127_t, uint239_t and uint511_t.
+template <int Bits>
+std::string ToString(const itmo_uint<Bits>& value);
+
+// Decimal value; honours the stream's width, fill and adjustment.
+template <int Bits>
+std::ostream& operator<<(std::ostream& stream, const itmo_uint<Bits>& value) {
+    return stream << ToString(value);
+}
+
+template <int Bits>
+constexpr uint64_t GetShift(const itmo_uint<Bits>& value);
+
+
+// Limb arithmetic behind the operators; defined here so that everything above is usable in constant expressions.
+namespace itmo_detail {
+
+// Value as N 64-bit limbs, least significant first.
+template <int N>
+struct Limbs {
+    uint64_t limb[N];
+};
+
+constexpr uint64_t LowMask(int bits) {
+    return bits % 64 == 0 ? ~0ull : (1ull << (bits % 64)) - 1;
+}
+
+// Everything about the layout of itmo_uint<Bits> that the kernels need, fixed at compile time.
+template <int Bits>
+struct Layout {
+    static constexpr int kDigits = itmo_uint<Bits>::kBytes;
+    static constexpr int kDigitBits = 7;
+    static constexpr int kPayloadBits = kDigits * kDigitBits;
+    static constexpr int kLimbCount = (Bits + 63) / 64;
+    static constexpr int kPayloadLimbs = (kPayloadBits + 63) / 64;
+    static constexpr uint64_t kTopLimbMask = LowMask(Bits);
+    static constexpr uint64_t kPayloadTopMask = LowMask(kPayloadBits);
+    static constexpr int kShiftBits = kDigits < 64 ? kDigits : 64;
+    static constexpr uint64_t kShiftMask = LowMask(kShiftBits);
+
+    using Value = Limbs<kLimbCount>;
+    using Payload = Limbs<kPayloadLimbs>;
+};
+
+template <int Bits>
+constexpr typename Layout<Bits>::Payload Unpack(const itmo_uint<Bits>& number) {
+    using L = Layout<Bits>;
+    typename L::Payload value{};
+    for (int i = 0; i < L::kDigits; i++) {
+        uint64_t digit = number.data[L::kDigits - 1 - i] & 0x7f;
+        int bit = L::kDigitBits * i;
+        value.limb[bit / 64] |= digit << (bit % 64);
+        if (bit % 64 > 64 - L::kDigitBits && bit / 64 + 1 < L::kPayloadLimbs) {
+            value.limb[bit / 64 + 1] |= digit >> (64 - bit % 64);
+        }
+    }
+    return value;
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> Pack(const typename Layout<Bits>::Payload& value) {
+    using L = Layout<Bits>;
+    itmo_uint<Bits> number{};
+    for (int i = 0; i < L::kDigits; i++) {
+        int bit = L::kDigitBits * i;
+        uint64_t digit = value.limb[bit / 64] >> (bit % 64);
+        if (bit % 64 > 64 - L::kDigitBits && bit / 64 + 1 < L::kPayloadLimbs) {
+            digit |= value.limb[bit / 64 + 1] << (64 - bit % 64);
+        }
+        number.data[L::kDigits - 1 - i] = digit & 0x7f;
+    }
+    return number;
+}
+
+template <int N>
+constexpr Limbs<N> ShiftLeft(const Limbs<N>& value, int count) {
+    Limbs<N> result{};
+    int words = count / 64;
+    int bits = count % 64;
+    for (int i = N - 1; i >= words; i--) {
+        result.limb[i] = value.limb[i - words] << bits;
+        if (bits != 0 && i > words) {
+            result.limb[i] |= value.limb[i - words - 1] >> (64 - bits);
+        }
+    }
+    return result;
+}
+
+template <int N>
+constexpr Limbs<N> ShiftRight(const Limbs<N>& value, int count) {
+    Limbs<N> result{};
+    int words = count / 64;
+    int bits = count % 64;
+    for (int i = 0; i < N - words; i++) {
+        result.limb[i] = value.limb[i + words] >> bits;
+        if (bits != 0 && i + words + 1 < N) {
+            result.limb[i] |= value.limb[i + words + 1] << (64 - bits);
+        }
+    }
+    return result;
+}
+
+// Circular left rotation of the payload.
+template <int Bits>
+constexpr typename Layout<Bits>::Payload Rotate(const typename Layout<Bits>::Payload& value, uint64_t count) {
+    using L = Layout<Bits>;
+    count %= L::kPayloadBits;
+    if (count == 0) {
+        return value;
+    }
+    typename L::Payload high = ShiftLeft(value, count);
+    typename L::Payload low = ShiftRight(value, L::kPayloadBits - count);
+    for (int i = 0; i < L::kPayloadLimbs; i++) {
+        high.limb[i] |= low.limb[i];
+    }
+    high.limb[L::kPayloadLimbs - 1] &= L::kPayloadTopMask;
+    return high;
+}
+
+template <int Bits>
+constexpr typename Layout<Bits>::Value ToLimbs(const itmo_uint<Bits>& number, uint64_t shift) {
+    using L = Layout<Bits>;
+    typename L::Payload payload = Rotate<Bits>(Unpack(number), L::kPayloadBits - shift % L::kPayloadBits);
+    typename L::Value value{};
+    for (int i = 0; i < L::kLimbCount; i++) {
+        value.limb[i] = payload.limb[i];
+    }
+    return value;
+}
+
+template <int Bits>
+constexpr typename Layout<Bits>::Value ToLimbs(const itmo_uint<Bits>& number) {
+    return ToLimbs(number, GetShift(number));
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> FromLimbs(const typename Layout<Bits>::Value& value, uint64_t shift) {
+    using L = Layout<Bits>;
+    typename L::Payload payload{};
+    for (int i = 0; i < L::kLimbCount; i++) {
+        payload.limb[i] = value.limb[i];
+    }
+    payload.limb[L::kLimbCount - 1] &= L::kTopLimbMask;
+    return ShiftFront(Pack<Bits>(payload), shift);
+}
+
+template <int Bits>
+constexpr typename Layout<Bits>::Value Truncate(typename Layout<Bits>::Value value) {
+    value.limb[Layout<Bits>::kLimbCount - 1] &= Layout<Bits>::kTopLimbMask;
+    return value;
+}
+
+template <int N>
+constexpr int Compare(const Limbs<N>& lhs, const Limbs<N>& rhs) {
+    for (int i = N - 1; i >= 0; i--) {
+        if (lhs.limb[i] != rhs.limb[i]) {
+            return lhs.limb[i] > rhs.limb[i] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+template <int N>
+constexpr Limbs<N> Add(const Limbs<N>& lhs, const Limbs<N>& rhs) {
+    Limbs<N> sum{};
+    uint64_t carry = 0;
+    for (int i = 0; i < N; i++) {
+        uint64_t part = lhs.limb[i] + carry;
+        carry = part < carry;
+        sum.limb[i] = part + rhs.limb[i];
+        carry += sum.limb[i] < part;
+    }
+    return sum;
+}
+
+template <int N>
+constexpr Limbs<N> Sub(const Limbs<N>& lhs, const Limbs<N>& rhs) {
+    Limbs<N> diff{};
+    uint64_t borrow = 0;
+    for (int i = 0; i < N; i++) {
+        uint64_t part = lhs.limb[i] - rhs.limb[i];
+        uint64_t next = lhs.limb[i] < rhs.limb[i];
+        diff.limb[i] = part - borrow;
+        borrow = next + (part < borrow);
+    }
+    return diff;
+}
+
+// 64x64 -> 128 bit partial product.
+constexpr void MulWord(uint64_t lhs, uint64_t rhs, uint64_t& high, uint64_t& low) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+    low = static_cast<uint64_t>(product);
+    high = static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t lhs_low = lhs & 0xffffffff;
+    uint64_t lhs_high = lhs >> 32;
+    uint64_t rhs_low = rhs & 0xffffffff;
+    uint64_t rhs_high = rhs >> 32;
+    uint64_t low_low = lhs_low * rhs_low;
+    uint64_t high_low = lhs_high * rhs_low;
+    uint64_t low_high = lhs_low * rhs_high;
+    uint64_t middle = (low_low >> 32) + (high_low & 0xffffffff) + (low_high & 0xffffffff);
+    low = (middle << 32) | (low_low & 0xffffffff);
+    high = lhs_high * rhs_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+#endif
+}
+
+// Schoolbook product of two limb vectors, keeping the lowest W limbs.
+template <int W, int N>
+constexpr Limbs<W> MulLimbs(const Limbs<N>& lhs, const Limbs<N>& rhs) {
+    Limbs<W> product{};
+    for (int i = 0; i < N && i < W; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < N && i + j < W; j++) {
+            uint64_t high;
+            uint64_t low;
+            MulWord(lhs.limb[i], rhs.limb[j], high, low);
+            low += carry;
+            high += low < carry;
+            product.limb[i + j] += low;
+            high += product.limb[i + j] < low;
+            carry = high;
+        }
+        if (i + N < W) {
+            product.limb[i + N] = carry;
+        }
+    }
+    return product;
+}
+
+template <int N>
+constexpr int BitLength(const Limbs<N>& value) {
+    for (int i = N - 1; i >= 0; i--) {
+        if (value.limb[i] != 0) {
+            return 64 * i + std::bit_width(value.limb[i]);
+        }
+    }
+    return 0;
+}
+
+// Quotient and remainder of lhs / rhs. Dividing by zero gives an all-ones quotient and lhs as remainder.
+template <int N>
+constexpr void DivLimbs(const Limbs<N>& lhs, const Limbs<N>& rhs, Limbs<N>& quotient, Limbs<N>& remainder) {
+    quotient = Limbs<N>{};
+    remainder = lhs;
+
+    int lhs_bits = BitLength(lhs);
+    int rhs_bits = BitLength(rhs);
+    if (rhs_bits == 0) {
+        for (int i = 0; i < N; i++) {
+            quotient.limb[i] = ~0ull;
+        }
+        return;
+    }
+    if (lhs_bits < rhs_bits) {
+        return;
+    }
+
+#ifdef __SIZEOF_INT128__
+    if (rhs_bits <= 64) {
+        uint64_t rest = 0;
+        for (int i = N - 1; i >= 0; i--) {
+            unsigned __int128 part = (static_cast<unsigned __int128>(rest) << 64) | lhs.limb[i];
+            quotient.limb[i] = static_cast<uint64_t>(part / rhs.limb[0]);
+            rest = static_cast<uint64_t>(part % rhs.limb[0]);
+        }
+        remainder = Limbs<N>{};
+        remainder.limb[0] = rest;
+        return;
+    }
+#endif
+
+    // Binary long division: one compare-and-subtract per quotient bit.
+    Limbs<N> divisor = ShiftLeft(rhs, lhs_bits - rhs_bits);
+    for (int i = lhs_bits - rhs_bits; i >= 0; i--) {
+        if (Compare(remainder, divisor) >= 0) {
+            remainder = Sub(remainder, divisor);
+            quotient.limb[i / 64] |= 1ull << (i % 64);
+        }
+        divisor = ShiftRight(divisor, 1);
+    }
+}
+
+// Multiplies by a single word and adds another; false if the top limb ends up above top_mask.
+template <int N>
+constexpr bool MulAddWord(Limbs<N>& value, uint64_t factor, uint64_t addend, uint64_t top_mask) {
+    uint64_t carry = addend;
+    for (int i = 0; i < N; i++) {
+        uint64_t high;
+        uint64_t low;
+        MulWord(value.limb[i], factor, high, low);
+        low += carry;
+        carry = high + (low < carry);
+        value.limb[i] = low;
+    }
+    return carry == 0 && value.limb[N - 1] <= top_mask;
+}
+
+inline constexpr uint64_t kPowersOfTen[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull
+};
+inline constexpr int kWordDigits = 16;
+
+// Eight ASCII characters as one word, first character in the lowest byte.
+constexpr uint64_t LoadEight(const char* str) {
+    uint64_t word = 0;
+    for (int i = 7; i >= 0; i--) {
+        word = (word << 8) | static_cast<uint8_t>(str[i]);
+    }
+    return word;
+}
+
+constexpr bool IsEightDigits(uint64_t word) {
+    return (word & 0xf0f0f0f0f0f0f0f0ull) == 0x3030303030303030ull
+        && ((word + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) == 0x3030303030303030ull;
+}
+
+// Value of eight ASCII digits, first character in the lowest byte: pairs, then quads, then all eight.
+constexpr uint64_t ParseEight(uint64_t word) {
+    word = ((word & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+    word = ((word & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+    return ((word & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32;
+}
+
+} // namespace itmo_detail
+
+// Working form of itmo_uint<Bits>: the un-rotated value as limbs and the shift as a plain integer.
+// Arithmetic on it never touches the ITMO encoding; Encode produces the encoded number on demand.
+template <int Bits>
+struct itmo_value {
+    typename itmo_detail::Layout<Bits>::Value limbs;
+    uint64_t shift;
+};
+
+using uint239_value_t = itmo_value<239>;
+
+template <int Bits>
+constexpr itmo_value<Bits> Decode(const itmo_uint<Bits>& number) {
+    uint64_t shift = GetShift(number);
+    return itmo_value<Bits>{itmo_detail::ToLimbs(number, shift), shift};
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> Encode(const itmo_value<Bits>& value) {
+    return itmo_detail::FromLimbs<Bits>(value.limbs, value.shift);
+}
+
+template <int Bits>
+constexpr itmo_value<Bits> operator+(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    return itmo_value<Bits>{itmo_detail::Truncate<Bits>(itmo_detail::Add(lhs.limbs, rhs.limbs)), (lhs.shift + rhs.shift) & L::kShiftMask};
+}
+
+template <int Bits>
+constexpr itmo_value<Bits> operator-(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    return itmo_value<Bits>{itmo_detail::Truncate<Bits>(itmo_detail::Sub(lhs.limbs, rhs.limbs)), (lhs.shift - rhs.shift) & L::kShiftMask};
+}
+
+template <int Bits>
+constexpr itmo_value<Bits> operator*(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    return itmo_value<Bits>{itmo_detail::Truncate<Bits>(itmo_detail::MulLimbs<L::kLimbCount>(lhs.limbs, rhs.limbs)), (lhs.shift + rhs.shift) & L::kShiftMask};
+}
+
+template <int Bits>
+constexpr itmo_value<Bits> operator/(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> quotient{{}, (lhs.shift - rhs.shift) & L::kShiftMask};
+    typename L::Value remainder{};
+    itmo_detail::DivLimbs(lhs.limbs, rhs.limbs, quotient.limbs, remainder);
+    quotient.limbs = itmo_detail::Truncate<Bits>(quotient.limbs);
+    return quotient;
+}
+
+template <int Bits>
+constexpr itmo_value<Bits> operator%(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> remainder{{}, (lhs.shift - rhs.shift) & L::kShiftMask};
+    typename L::Value quotient{};
+    itmo_detail::DivLimbs(lhs.limbs, rhs.limbs, quotient, remainder.limbs);
+    return remainder;
+}
+
+// Like the itmo_uint comparisons, only the values are compared, not the shifts.
+template <int Bits>
+constexpr bool operator==(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    return itmo_detail::Compare(lhs.limbs, rhs.limbs) == 0;
+}
+
+template <int Bits>
+constexpr bool operator!=(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <int Bits>
+constexpr bool operator>=(const itmo_value<Bits>& lhs, const itmo_value<Bits>& rhs) {
+    return itmo_detail::Compare(lhs.limbs, rhs.limbs) >= 0;
+}
+
+template <typename T>
+constexpr T FromInt(uint32_t value, uint64_t shift) {
+    typename itmo_detail::Layout<T::kBits>::Value limbs{};
+    limbs.limb[0] = value;
+    return itmo_detail::FromLimbs<T::kBits>(limbs, shift);
+}
+
+constexpr uint239_t FromInt(uint32_t value, uint32_t shift) {
+    return FromInt<uint239_t>(value, shift);
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftNumber(itmo_uint<Bits> number, uint32_t c_shift) {
+    return itmo_detail::Pack<Bits>(itmo_detail::Rotate<Bits>(itmo_detail::Unpack(number), c_shift));
+}
+
+template <int Bits>
+constexpr std::from_chars_result FromChars(const char* first, const char* last, itmo_uint<Bits>& value, uint64_t shift) {
+    using L = itmo_detail::Layout<Bits>;
+    const char* ptr = first;
+    typename L::Value number{};
+    bool fits = true;
+
+    while (ptr < last) {
+        uint64_t chunk = 0;
+        int digits = 0;
+        while (digits < itmo_detail::kWordDigits && last - ptr >= 8 && itmo_detail::IsEightDigits(itmo_detail::LoadEight(ptr))) {
+            chunk = chunk * itmo_detail::kPowersOfTen[8] + itmo_detail::ParseEight(itmo_detail::LoadEight(ptr));
+            digits += 8;
+            ptr += 8;
+        }
+        while (digits < itmo_detail::kWordDigits && ptr < last && *ptr >= '0' && *ptr <= '9') {
+            chunk = chunk * 10 + (*ptr - '0');
+            digits++;
+            ptr++;
+        }
+        if (digits == 0) {
+            break;
+        }
+        fits = itmo_detail::MulAddWord(number, itmo_detail::kPowersOfTen[digits], chunk, L::kTopLimbMask) && fits;
+    }
+
+    if (ptr == first) {
+        return {first, std::errc::invalid_argument};
+    }
+    if (!fits) {
+        return {ptr, std::errc::result_out_of_range};
+    }
+    value = itmo_detail::FromLimbs<Bits>(number, shift);
+    return {ptr, std::errc()};
+}
+
+template <typename T>
+constexpr T FromString(const char* str, uint64_t shift) {
+    const char* last = str + std::char_traits<char>::length(str);
+    T number{};
+    std::from_chars_result result = FromChars(str, last, number, shift);
+
+    if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range("FromString: value does not fit in " + std::to_string(T::kBits) + " bits");
+    }
+    if (result.ec != std::errc() || result.ptr != last) {
+        throw std::invalid_argument("FromString: invalid character in \"" + std::string(str) + "\"");
+    }
+    return number;
+}
+
+constexpr uint239_t FromString(const char* str, uint32_t shift) {
+    return FromString<uint239_t>(str, shift);
+}
+
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftBack(itmo_uint<Bits> number, uint64_t shift) {
+    using L = itmo_detail::Layout<Bits>;
+    shift &= L::kShiftMask;
+    return itmo_detail::Pack<Bits>(itmo_detail::Rotate<Bits>(itmo_detail::Unpack(number), L::kPayloadBits - shift % L::kPayloadBits));
+}
+
+// Only shift mod 2^kShiftBits can be stored, so the payload is rotated by that and not by the full shift.
+template <int Bits>
+constexpr itmo_uint<Bits> ShiftFront(itmo_uint<Bits> number, uint64_t shift) {
+    using L = itmo_detail::Layout<Bits>;
+    shift &= L::kShiftMask;
+    itmo_uint<Bits> sum_num = itmo_detail::Pack<Bits>(itmo_detail::Rotate<Bits>(itmo_detail::Unpack(number), shift));
+
+    for (int i = L::kDigits - 1; i >= L::kDigits - L::kShiftBits; i--) {
+        sum_num.data[i] |= (shift & 1) << 7;
+        shift >>= 1;
+    }
+    return sum_num;
+}
+
 
-uint239_t ShiftBack(uint239_t num, uint32_t shift);
+template <int Bits>
+constexpr itmo_uint<Bits> operator+(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return Encode(Decode(lhs) + Decode(rhs));
+}
 
-uint239_t ShiftFront(uint239_t num, uint32_t shift);
+template <int Bits>
+constexpr itmo_uint<Bits> operator-(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return Encode(Decode(lhs) - Decode(rhs));
+}
 
-uint239_t FromInt(uint32_t value, uint32_t shift);
+template <int Bits>
+constexpr itmo_uint<Bits> operator*(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return Encode(Decode(lhs) * Decode(rhs));
+}
 
-uint239_t FromString(const char* str, uint32_t shift);
+template <int Bits>
+constexpr itmo_uint_wide<Bits> MulWide(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> left = Decode(lhs);
+    itmo_value<Bits> right = Decode(rhs);
+    itmo_detail::Limbs<2 * L::kLimbCount> product = itmo_detail::MulLimbs<2 * L::kLimbCount>(left.limbs, right.limbs);
+    itmo_detail::Limbs<2 * L::kLimbCount> top = itmo_detail::ShiftRight(product, Bits);
 
-uint239_t operator+(const uint239_t& lhs, const uint239_t& rhs);
+    typename L::Value low{};
+    typename L::Value high{};
+    for (int i = 0; i < L::kLimbCount; i++) {
+        low.limb[i] = product.limb[i];
+        high.limb[i] = top.limb[i];
+    }
 
-uint239_t operator-(const uint239_t& lhs, const uint239_t& rhs);
+    uint64_t shift = (left.shift + right.shift) & L::kShiftMask;
+    return itmo_uint_wide<Bits>{itmo_detail::FromLimbs<Bits>(high, shift), itmo_detail::FromLimbs<Bits>(low, shift)};
+}
 
-uint239_t operator*(const uint239_t& lhs, const uint239_t& rhs);
+template <int Bits>
+constexpr itmo_uint<Bits> operator/(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return DivMod(lhs, rhs).quot;
+}
 
-uint239_t operator/(const uint239_t& lhs, const uint239_t& rhs);
+template <int Bits>
+constexpr itmo_uint<Bits> operator%(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return DivMod(lhs, rhs).rem;
+}
 
-bool operator==(const uint239_t& lhs, const uint239_t& rhs);
+template <int Bits>
+constexpr itmo_uint_div<Bits> DivMod(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    using L = itmo_detail::Layout<Bits>;
+    itmo_value<Bits> left = Decode(lhs);
+    itmo_value<Bits> right = Decode(rhs);
+    typename L::Value quotient{};
+    typename L::Value remainder{};
+    itmo_detail::DivLimbs(left.limbs, right.limbs, quotient, remainder);
 
-bool operator!=(const uint239_t& lhs, const uint239_t& rhs);
+    uint64_t shift = (left.shift - right.shift) & L::kShiftMask;
+    return itmo_uint_div<Bits>{itmo_detail::FromLimbs<Bits>(quotient, shift), itmo_detail::FromLimbs<Bits>(remainder, shift)};
+}
 
-bool operator>=(const uint239_t& lhs, const uint239_t& rhs); 
+template <int Bits>
+constexpr bool operator==(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return Decode(lhs) == Decode(rhs);
+}
 
-std::ostream& operator<<(std::ostream& stream, const uint239_t& value);
+template <int Bits>
+constexpr bool operator!=(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return !(lhs == rhs);
+}
 
-uint64_t GetShift(const uint239_t& value);
+template <int Bits>
+constexpr bool operator>=(const itmo_uint<Bits>& lhs, const itmo_uint<Bits>& rhs) {
+    return Decode(lhs) >= Decode(rhs);
+}
 
+template <int Bits>
+constexpr uint64_t GetShift(const itmo_uint<Bits>& value) {
+    using L = itmo_detail::Layout<Bits>;
+    uint64_t shift = 0;
+    for (int i = L::kDigits - 1; i >= L::kDigits - L::kShiftBits; i--) {
+        shift |= static_cast<uint64_t>(value.data[i] >> 7) << (L::kDigits - 1 - i);
+    }
+    return shift;
+}
@@ -0,0 +1,337 @@
+#include "uint239_vector.h"
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define ITMO_AVX2_KERNELS
+#endif
+
+using Limbs = itmo_detail::Layout<239>::Value;
+
+namespace {
+
+const int kLanes = 4;
+
+Limbs Load(const uint239_vector& values, std::size_t index) {
+    Limbs value{};
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        value.limb[k] = values.limbs(k)[index];
+    }
+    return value;
+}
+
+void Store(uint239_vector& values, std::size_t index, Limbs value, uint64_t shift) {
+    value.limb[uint239_vector::kLimbCount - 1] &= itmo_detail::Layout<239>::kTopLimbMask;
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        values.limbs(k)[index] = value.limb[k];
+    }
+    values.shifts()[index] = shift & itmo_detail::Layout<239>::kShiftMask;
+}
+
+void CheckSizes(const uint239_vector& lhs, const uint239_vector& rhs) {
+    if (lhs.size() != rhs.size()) {
+        throw std::invalid_argument("uint239_vector: operands have different sizes");
+    }
+}
+
+// Index of the smaller (less = true) or larger element, the earlier one on ties.
+std::size_t Pick(const uint239_vector& values, std::size_t best, std::size_t candidate, bool less) {
+    int order = itmo_detail::Compare(Load(values, candidate), Load(values, best));
+    if (order == 0) {
+        return candidate < best ? candidate : best;
+    }
+    return (order < 0) == less ? candidate : best;
+}
+
+#ifdef ITMO_AVX2_KERNELS
+
+bool HasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// All-ones in the lanes where lhs < rhs as unsigned 64-bit numbers.
+__attribute__((target("avx2"))) inline __m256i LessThan(__m256i lhs, __m256i rhs) {
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(rhs, sign), _mm256_xor_si256(lhs, sign));
+}
+
+// Full-width lhs < rhs for four values, decided from the lowest limb up like a borrow chain.
+__attribute__((target("avx2"))) inline __m256i WideLessThan(const __m256i* lhs, const __m256i* rhs) {
+    __m256i less = _mm256_setzero_si256();
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        __m256i equal = _mm256_cmpeq_epi64(lhs[k], rhs[k]);
+        less = _mm256_or_si256(LessThan(lhs[k], rhs[k]), _mm256_and_si256(equal, less));
+    }
+    return less;
+}
+
+__attribute__((target("avx2"))) inline __m256i LoadLanes(const uint64_t* data, std::size_t index) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(data + index));
+}
+
+__attribute__((target("avx2"))) inline void StoreLanes(uint64_t* data, std::size_t index, __m256i lanes) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(data + index), lanes);
+}
+
+// sum += addend limb by limb with the carry kept as an all-ones mask per lane.
+__attribute__((target("avx2"))) inline void AddLanes(__m256i* sum, const __m256i* addend) {
+    __m256i carry = _mm256_setzero_si256();
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        __m256i partial = _mm256_add_epi64(sum[k], addend[k]);
+        __m256i overflow = LessThan(partial, sum[k]);
+        sum[k] = _mm256_sub_epi64(partial, carry);
+        carry = _mm256_or_si256(overflow, _mm256_and_si256(carry, _mm256_cmpeq_epi64(sum[k], _mm256_setzero_si256())));
+    }
+    sum[uint239_vector::kLimbCount - 1] = _mm256_and_si256(sum[uint239_vector::kLimbCount - 1],
+                                                           _mm256_set1_epi64x(itmo_detail::Layout<239>::kTopLimbMask));
+}
+
+// The kernels handle whole groups of four values and return how many they processed.
+__attribute__((target("avx2"))) std::size_t AddAvx2(const uint239_vector& lhs, const uint239_vector& rhs, uint239_vector& result) {
+    const __m256i shift_mask = _mm256_set1_epi64x(itmo_detail::Layout<239>::kShiftMask);
+    std::size_t i = 0;
+    for (; i + kLanes <= lhs.size(); i += kLanes) {
+        __m256i sum[uint239_vector::kLimbCount];
+        __m256i addend[uint239_vector::kLimbCount];
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            sum[k] = LoadLanes(lhs.limbs(k), i);
+            addend[k] = LoadLanes(rhs.limbs(k), i);
+        }
+        AddLanes(sum, addend);
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            StoreLanes(result.limbs(k), i, sum[k]);
+        }
+        __m256i shift = _mm256_add_epi64(LoadLanes(lhs.shifts(), i), LoadLanes(rhs.shifts(), i));
+        StoreLanes(result.shifts(), i, _mm256_and_si256(shift, shift_mask));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) std::size_t SubAvx2(const uint239_vector& lhs, const uint239_vector& rhs, uint239_vector& result) {
+    const __m256i shift_mask = _mm256_set1_epi64x(itmo_detail::Layout<239>::kShiftMask);
+    std::size_t i = 0;
+    for (; i + kLanes <= lhs.size(); i += kLanes) {
+        __m256i borrow = _mm256_setzero_si256();
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            __m256i minuend = LoadLanes(lhs.limbs(k), i);
+            __m256i subtrahend = LoadLanes(rhs.limbs(k), i);
+            __m256i partial = _mm256_sub_epi64(minuend, subtrahend);
+            __m256i underflow = LessThan(minuend, subtrahend);
+            __m256i diff = _mm256_add_epi64(partial, borrow);
+            borrow = _mm256_or_si256(underflow, _mm256_and_si256(borrow, _mm256_cmpeq_epi64(partial, _mm256_setzero_si256())));
+            if (k == uint239_vector::kLimbCount - 1) {
+                diff = _mm256_and_si256(diff, _mm256_set1_epi64x(itmo_detail::Layout<239>::kTopLimbMask));
+            }
+            StoreLanes(result.limbs(k), i, diff);
+        }
+        __m256i shift = _mm256_sub_epi64(LoadLanes(lhs.shifts(), i), LoadLanes(rhs.shifts(), i));
+        StoreLanes(result.shifts(), i, _mm256_and_si256(shift, shift_mask));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) std::size_t CompareAvx2(const uint239_vector& lhs, const uint239_vector& rhs, int8_t* result) {
+    std::size_t i = 0;
+    for (; i + kLanes <= lhs.size(); i += kLanes) {
+        __m256i left[uint239_vector::kLimbCount];
+        __m256i right[uint239_vector::kLimbCount];
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            left[k] = LoadLanes(lhs.limbs(k), i);
+            right[k] = LoadLanes(rhs.limbs(k), i);
+        }
+        int less = _mm256_movemask_pd(_mm256_castsi256_pd(WideLessThan(left, right)));
+        int greater = _mm256_movemask_pd(_mm256_castsi256_pd(WideLessThan(right, left)));
+        for (int lane = 0; lane < kLanes; lane++) {
+            result[i + lane] = static_cast<int8_t>(((greater >> lane) & 1) - ((less >> lane) & 1));
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) std::size_t SumAvx2(const uint239_vector& values, Limbs& sum, uint64_t& shift) {
+    __m256i lanes[uint239_vector::kLimbCount] = {};
+    __m256i shifts = _mm256_setzero_si256();
+    const __m256i shift_mask = _mm256_set1_epi64x(itmo_detail::Layout<239>::kShiftMask);
+    std::size_t i = 0;
+    for (; i + kLanes <= values.size(); i += kLanes) {
+        __m256i addend[uint239_vector::kLimbCount];
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            addend[k] = LoadLanes(values.limbs(k), i);
+        }
+        AddLanes(lanes, addend);
+        shifts = _mm256_and_si256(_mm256_add_epi64(shifts, LoadLanes(values.shifts(), i)), shift_mask);
+    }
+
+    alignas(32) uint64_t lane_limbs[uint239_vector::kLimbCount][kLanes];
+    alignas(32) uint64_t lane_shifts[kLanes];
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lane_limbs[k]), lanes[k]);
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_shifts), shifts);
+    for (int lane = 0; lane < kLanes; lane++) {
+        Limbs partial{};
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            partial.limb[k] = lane_limbs[k][lane];
+        }
+        sum = itmo_detail::Add(sum, partial);
+        shift += lane_shifts[lane];
+    }
+    return i;
+}
+
+// Keeps per lane the index of the best element so far; `less` selects Min, otherwise Max.
+__attribute__((target("avx2"))) std::size_t ExtremumAvx2(const uint239_vector& values, bool less, std::size_t& best) {
+    if (values.size() < kLanes) {
+        return 0;
+    }
+    __m256i best_limbs[uint239_vector::kLimbCount];
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        best_limbs[k] = LoadLanes(values.limbs(k), 0);
+    }
+    __m256i best_index = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i index = best_index;
+    const __m256i step = _mm256_set1_epi64x(kLanes);
+
+    std::size_t i = kLanes;
+    for (; i + kLanes <= values.size(); i += kLanes) {
+        index = _mm256_add_epi64(index, step);
+        __m256i candidate[uint239_vector::kLimbCount];
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            candidate[k] = LoadLanes(values.limbs(k), i);
+        }
+        __m256i take = less ? WideLessThan(candidate, best_limbs) : WideLessThan(best_limbs, candidate);
+        for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+            best_limbs[k] = _mm256_blendv_epi8(best_limbs[k], candidate[k], take);
+        }
+        best_index = _mm256_blendv_epi8(best_index, index, take);
+    }
+
+    alignas(32) uint64_t lane_index[kLanes];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_index), best_index);
+    best = lane_index[0];
+    for (int lane = 1; lane < kLanes; lane++) {
+        best = Pick(values, best, lane_index[lane], less);
+    }
+    return i;
+}
+
+#endif
+
+std::size_t Extremum(const uint239_vector& values, bool less) {
+    if (values.size() == 0) {
+        throw std::out_of_range("uint239_vector: extremum of an empty vector");
+    }
+    std::size_t best = 0;
+    std::size_t i = 1;
+#ifdef ITMO_AVX2_KERNELS
+    if (HasAvx2() && values.size() >= kLanes) {
+        i = ExtremumAvx2(values, less, best);
+    }
+#endif
+    for (; i < values.size(); i++) {
+        best = Pick(values, best, i, less);
+    }
+    return best;
+}
+
+} // namespace
+
+uint239_vector::uint239_vector(std::size_t size) {
+    for (LimbArray& limbs : limbs_) {
+        limbs.resize(size);
+    }
+    shifts_.resize(size);
+}
+
+void uint239_vector::push_back(const uint239_t& value) {
+    Limbs limbs = itmo_detail::ToLimbs(value);
+    for (int k = 0; k < kLimbCount; k++) {
+        limbs_[k].push_back(limbs.limb[k]);
+    }
+    shifts_.push_back(GetShift(value));
+}
+
+uint239_t uint239_vector::operator[](std::size_t index) const {
+    return itmo_detail::FromLimbs<239>(Load(*this, index), shifts_[index]);
+}
+
+void uint239_vector::set(std::size_t index, const uint239_t& value) {
+    Store(*this, index, itmo_detail::ToLimbs(value), GetShift(value));
+}
+
+void uint239_vector::reserve(std::size_t capacity) {
+    for (LimbArray& limbs : limbs_) {
+        limbs.reserve(capacity);
+    }
+    shifts_.reserve(capacity);
+}
+
+uint239_vector operator+(const uint239_vector& lhs, const uint239_vector& rhs) {
+    CheckSizes(lhs, rhs);
+    uint239_vector result(lhs.size());
+    std::size_t i = 0;
+#ifdef ITMO_AVX2_KERNELS
+    if (HasAvx2()) {
+        i = AddAvx2(lhs, rhs, result);
+    }
+#endif
+    for (; i < lhs.size(); i++) {
+        Store(result, i, itmo_detail::Add(Load(lhs, i), Load(rhs, i)), lhs.shifts()[i] + rhs.shifts()[i]);
+    }
+    return result;
+}
+
+uint239_vector operator-(const uint239_vector& lhs, const uint239_vector& rhs) {
+    CheckSizes(lhs, rhs);
+    uint239_vector result(lhs.size());
+    std::size_t i = 0;
+#ifdef ITMO_AVX2_KERNELS
+    if (HasAvx2()) {
+        i = SubAvx2(lhs, rhs, result);
+    }
+#endif
+    for (; i < lhs.size(); i++) {
+        Store(result, i, itmo_detail::Sub(Load(lhs, i), Load(rhs, i)), lhs.shifts()[i] - rhs.shifts()[i]);
+    }
+    return result;
+}
+
+std::vector<int8_t> Compare(const uint239_vector& lhs, const uint239_vector& rhs) {
+    CheckSizes(lhs, rhs);
+    std::vector<int8_t> result(lhs.size());
+    std::size_t i = 0;
+#ifdef ITMO_AVX2_KERNELS
+    if (HasAvx2()) {
+        i = CompareAvx2(lhs, rhs, result.data());
+    }
+#endif
+    for (; i < lhs.size(); i++) {
+        result[i] = static_cast<int8_t>(itmo_detail::Compare(Load(lhs, i), Load(rhs, i)));
+    }
+    return result;
+}
+
+uint239_t Sum(const uint239_vector& values) {
+    Limbs sum{};
+    uint64_t shift = 0;
+    std::size_t i = 0;
+#ifdef ITMO_AVX2_KERNELS
+    if (HasAvx2()) {
+        i = SumAvx2(values, sum, shift);
+    }
+#endif
+    for (; i < values.size(); i++) {
+        sum = itmo_detail::Add(sum, Load(values, i));
+        shift += values.shifts()[i];
+    }
+    return itmo_detail::FromLimbs<239>(sum, shift & itmo_detail::Layout<239>::kShiftMask);
+}
+
+uint239_t Min(const uint239_vector& values) {
+    return values[Extremum(values, true)];
+}
+
+uint239_t Max(const uint239_vector& values) {
+    return values[Extremum(values, false)];
+}
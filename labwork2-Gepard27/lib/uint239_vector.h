@@ -0,0 +1,91 @@
+#pragma once
+#include "number.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+// Allocator handing out storage aligned to a 64-byte cache line.
+template <typename T>
+struct CacheLineAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t kAlignment{64};
+
+    CacheLineAllocator() = default;
+
+    template <typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), kAlignment));
+    }
+
+    void deallocate(T* pointer, std::size_t) {
+        ::operator delete(pointer, kAlignment);
+    }
+
+    template <typename U>
+    bool operator==(const CacheLineAllocator<U>&) const {
+        return true;
+    }
+};
+
+// Many uint239_t stored as structure of arrays: limb k of every value is contiguous,
+// values are kept un-rotated, and shifts sit in their own array.
+class uint239_vector {
+public:
+    using LimbArray = std::vector<uint64_t, CacheLineAllocator<uint64_t>>;
+    static constexpr int kLimbCount = itmo_detail::Layout<239>::kLimbCount;
+
+    uint239_vector() = default;
+
+    explicit uint239_vector(std::size_t size);
+
+    void push_back(const uint239_t& value);
+
+    uint239_t operator[](std::size_t index) const;
+
+    void set(std::size_t index, const uint239_t& value);
+
+    std::size_t size() const {
+        return shifts_.size();
+    }
+
+    void reserve(std::size_t capacity);
+
+    const uint64_t* limbs(int limb) const {
+        return limbs_[limb].data();
+    }
+
+    uint64_t* limbs(int limb) {
+        return limbs_[limb].data();
+    }
+
+    const uint64_t* shifts() const {
+        return shifts_.data();
+    }
+
+    uint64_t* shifts() {
+        return shifts_.data();
+    }
+
+private:
+    LimbArray limbs_[kLimbCount];
+    LimbArray shifts_;
+};
+
+// Element-wise operations; both vectors must have the same size, otherwise std::invalid_argument is thrown.
+uint239_vector operator+(const uint239_vector& lhs, const uint239_vector& rhs);
+
+uint239_vector operator-(const uint239_vector& lhs, const uint239_vector& rhs);
+
+// -1, 0 or 1 per element for lhs[i] <, == or > rhs[i].
+std::vector<int8_t> Compare(const uint239_vector& lhs, const uint239_vector& rhs);
+
+// Sum of all elements (shifts add up as for operator+); zero with shift 0 for an empty vector.
+uint239_t Sum(const uint239_vector& values);
+
+// Smallest / largest element with its own shift; std::out_of_range for an empty vector.
+uint239_t Min(const uint239_vector& values);
+
+uint239_t Max(const uint239_vector& values);
@@ -0,0 +1,89 @@
+#include <lib/modular.h>
+#include <gtest/gtest.h>
+#include <tuple>
+
+
+using TValue = std::pair<const char*, uint32_t>;
+
+class ModularTestsSuite
+    : public testing::TestWithParam<
+        std::tuple<
+            const char*, // modulus
+            TValue,      // lhs
+            TValue,      // rhs, also the exponent
+            const char*, // ModMul result
+            const char*  // ModPow result
+        >
+    >
+{
+};
+
+TEST_P(ModularTestsSuite, MulPowTest) {
+    uint239_montgomery_t context = MakeMontgomery(FromString(std::get<0>(GetParam()), 0));
+    uint239_t a = FromString(std::get<1>(GetParam()).first, std::get<1>(GetParam()).second);
+    uint239_t b = FromString(std::get<2>(GetParam()).first, std::get<2>(GetParam()).second);
+
+    uint239_t product = ModMul(a, b, context);
+    ASSERT_EQ(product, FromString(std::get<3>(GetParam()), 0));
+    ASSERT_EQ(GetShift(product), GetShift(a) + GetShift(b));
+
+    uint239_t power = ModPow(a, b, context);
+    ASSERT_EQ(power, FromString(std::get<4>(GetParam()), 0));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    ModularTestsSuite,
+    testing::Values(
+        std::make_tuple("883423532389192164791648750371459257913740680787209250831401603943104513",
+                        TValue{"123456789012345678901234567890123456789012345678901234567890", 5},
+                        TValue{"98765432109876543210987654321098765432109876543210", 7},
+                        "69343258816299743041842985434637904176557879654921044415500152430972068",
+                        "679808109296421240735992349473583418750734681929147685702914254562695148"),
+        std::make_tuple("883423532389192164791648750371459257913740680787209250831401603943104513",
+                        TValue{"123456789012345678901234567890123456789012345678901234567890", 0},
+                        TValue{"65537", 1},
+                        "8090987581502098758150209875815020987581502098758150209875806930",
+                        "525429733293075946646555516919501496775630685441843132986422444703521564"),
+        std::make_tuple("19033773762426864463472998628720641", TValue{"7", 3}, TValue{"1000000000000000000000000000000", 0},
+                        "7000000000000000000000000000000", "13309260087069087153734873689027193"),
+        std::make_tuple("1000000007", TValue{"2", 0}, TValue{"0", 0}, "0", "1"),
+        std::make_tuple("1", TValue{"5", 0}, TValue{"3", 0}, "0", "0")
+    )
+);
+
+TEST(ModularTest, LargeExponent) {
+    uint239_montgomery_t context = MakeMontgomery(FromString("883423532389192164791648750371459257913740680787209250831401603943104513", 0));
+    uint239_t a = FromString("123456789012345678901234567890123456789012345678901234567890", 0);
+    uint239_t exponent = ShiftFront(FromString("441711766194596082395824375185729628956870974218904739530401550323167289", 0), 100);
+
+    ASSERT_EQ(ModPow(a, exponent, context), FromString("667833603984709811280942446773200775278930809728045024940758455670904880", 0));
+}
+
+TEST(ModularTest, Inverse) {
+    uint239_montgomery_t context = MakeMontgomery(FromString("883423532389192164791648750371459257913740680787209250831401603943104513", 0));
+    uint239_t a = FromString("123456789012345678901234567890123456789012345678901234567890", 9);
+
+    std::optional<uint239_t> inverse = ModInverse(a, context);
+    ASSERT_TRUE(inverse.has_value());
+    ASSERT_EQ(*inverse, FromString("156790537050106065014716089689507512902453372021491559267174231882540436", 0));
+    ASSERT_EQ(ModMul(a, *inverse, context), FromInt(1, 0));
+    ASSERT_EQ(GetShift(ModMul(a, *inverse, context)), 0);
+
+    uint239_montgomery_t small = MakeMontgomery(FromInt(15, 0));
+    ASSERT_FALSE(ModInverse(FromInt(6, 0), small).has_value());
+    ASSERT_FALSE(ModInverse(FromInt(30, 0), small).has_value());
+    ASSERT_EQ(*ModInverse(FromInt(7, 0), small), FromInt(13, 0));
+    ASSERT_THROW(MakeMontgomery(FromInt(16, 0)), std::invalid_argument);
+}
+
+TEST(ModularTest, OtherWidths) {
+    itmo_montgomery<127> context = MakeMontgomery(FromString<uint127_t>("170141183460469231731687303715884105727", 0));
+    uint127_t three = FromInt<uint127_t>(3, 0);
+    uint127_t expected = FromString<uint127_t>("113427455640312821154458202477256070485", 0);
+
+    ASSERT_EQ(ModPow(three, FromString<uint127_t>("170141183460469231731687303715884105725", 0), context), expected);
+    ASSERT_EQ(*ModInverse(three, context), expected);
+}
+
+static_assert(ModPow(FromInt(3, 0), FromInt(200, 0), MakeMontgomery(FromInt(1000000007, 0))) == FromInt(136318165, 0));
@@ -0,0 +1,178 @@
+#include <lib/modular.h>
+#include <lib/number.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Times the operators of uint239_t in ns/op. Usage: number_benchmark [iterations]
+// Configure with -DCMAKE_BUILD_TYPE=Release, the operators are inline and unoptimized numbers mean nothing.
+namespace {
+
+const std::size_t kOperands = 1024;
+
+template <typename T>
+void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+template <typename Body>
+double NsPerOp(std::size_t iterations, Body body) {
+    for (std::size_t i = 0; i < kOperands; i++) {
+        body(i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        body(i % kOperands);
+    }
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(finish - start).count() / iterations;
+}
+
+void Report(const std::string& operation, const std::string& shift, const std::string& operand, double ns) {
+    std::cout << std::left << std::setw(22) << operation << std::setw(12) << shift << std::setw(12) << operand
+              << std::right << std::fixed << std::setprecision(1) << std::setw(10) << ns << '\n';
+}
+
+std::string RandomDigits(std::mt19937_64& random, int bits) {
+    // Decimal string of a random value below 2^bits.
+    uint239_t value = FromInt(0, 0);
+    for (int i = 0; i < bits; i += 31) {
+        int width = bits - i < 31 ? bits - i : 31;
+        value = value * FromInt(1u << width, 0) + FromInt(random() & ((1u << width) - 1), 0);
+    }
+    return ToString(value);
+}
+
+struct Operands {
+    std::vector<std::string> digits;
+    std::vector<uint239_t> lhs;
+    std::vector<uint239_t> rhs;
+};
+
+// Left operands of `bits` bits, right operands of half that width so that / has a real quotient.
+Operands MakeOperands(std::mt19937_64& random, int bits, uint64_t shift) {
+    Operands operands;
+    for (std::size_t i = 0; i < kOperands; i++) {
+        operands.digits.push_back(RandomDigits(random, bits));
+        operands.lhs.push_back(ShiftFront(FromString(operands.digits.back().c_str(), 0), shift));
+        std::string divisor = RandomDigits(random, bits / 2 + 1);
+        operands.rhs.push_back(ShiftFront(FromString(divisor.c_str(), 0) + FromInt(1, 0), shift / 3));
+    }
+    return operands;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::mt19937_64 random(239);
+
+    std::cout << std::left << std::setw(22) << "operation" << std::setw(12) << "shift" << std::setw(12) << "operand"
+              << std::right << std::setw(10) << "ns/op" << '\n';
+
+    const uint64_t kShifts[] = {0, 1, 122, 244, (1ull << 35) - 1};
+    const int kBits[] = {32, 120, 238};
+
+    for (int bits : kBits) {
+        for (uint64_t shift : kShifts) {
+            Operands operands = MakeOperands(random, bits, shift);
+            std::string shift_name = std::to_string(shift);
+            std::string operand_name = std::to_string(bits) + " bit";
+            const std::vector<uint239_t>& lhs = operands.lhs;
+            const std::vector<uint239_t>& rhs = operands.rhs;
+
+            Report("FromInt", shift_name, "32 bit", NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(FromInt(static_cast<uint32_t>(i * 2654435761u), static_cast<uint32_t>(shift + i)));
+            }));
+            Report("FromString", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(FromString(operands.digits[i].c_str(), static_cast<uint32_t>(shift)));
+            }));
+            Report("+", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] + rhs[i]);
+            }));
+            Report("-", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] - rhs[i]);
+            }));
+            Report("*", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] * rhs[i]);
+            }));
+            Report("/", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] / rhs[i]);
+            }));
+            Report("==", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] == rhs[(i + 1) % kOperands]);
+            }));
+            Report("GetShift", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(GetShift(lhs[i]));
+            }));
+            Report("ShiftFront", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(ShiftFront(lhs[i], shift + i));
+            }));
+            Report("ShiftBack", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(ShiftBack(lhs[i], shift + i));
+            }));
+            Report("ShiftNumber", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(ShiftNumber(lhs[i], static_cast<uint32_t>(shift + i)));
+            }));
+            Report("chain a*b+a-b", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                DoNotOptimize(lhs[i] * rhs[i] + lhs[i] - rhs[i]);
+            }));
+            Report("chain (value)", shift_name, operand_name, NsPerOp(iterations, [&](std::size_t i) {
+                uint239_value_t left = Decode(lhs[i]);
+                uint239_value_t right = Decode(rhs[i]);
+                DoNotOptimize(Encode(left * right + left - right));
+            }));
+        }
+    }
+
+    {
+        // Modular multiplication against the plain * followed by %, and a full-size ModPow.
+        Operands operands = MakeOperands(random, 238, 0);
+        const std::vector<uint239_t>& lhs = operands.lhs;
+        const std::vector<uint239_t>& rhs = operands.rhs;
+        uint239_t modulus = FromString("883423532389192164791648750371459257913740680787209250831401603943104513", 0);
+        uint239_montgomery_t context = MakeMontgomery(modulus);
+
+        Report("ModMul", "0", "238 bit", NsPerOp(iterations, [&](std::size_t i) {
+            DoNotOptimize(ModMul(lhs[i], rhs[i], context));
+        }));
+        Report("* then %", "0", "238 bit", NsPerOp(iterations, [&](std::size_t i) {
+            DoNotOptimize(MulWide(lhs[i], rhs[i]).low % modulus);
+        }));
+        Report("ModPow", "0", "238 bit", NsPerOp(iterations / 100 + 1, [&](std::size_t i) {
+            DoNotOptimize(ModPow(lhs[i], lhs[(i + 1) % kOperands], context));
+        }));
+    }
+
+#ifdef __SIZEOF_INT128__
+    // The same loops on the built-in 128-bit type, as the floor for what the operators could cost.
+    std::vector<unsigned __int128> lhs;
+    std::vector<unsigned __int128> rhs;
+    for (std::size_t i = 0; i < kOperands; i++) {
+        lhs.push_back((static_cast<unsigned __int128>(random()) << 56) ^ random());
+        rhs.push_back((random() >> 4) + 1);
+    }
+    Report("unsigned __int128 +", "-", "120 bit", NsPerOp(iterations, [&](std::size_t i) {
+        DoNotOptimize(lhs[i] + rhs[i]);
+    }));
+    Report("unsigned __int128 -", "-", "120 bit", NsPerOp(iterations, [&](std::size_t i) {
+        DoNotOptimize(lhs[i] - rhs[i]);
+    }));
+    Report("unsigned __int128 *", "-", "120 bit", NsPerOp(iterations, [&](std::size_t i) {
+        DoNotOptimize(lhs[i] * rhs[i]);
+    }));
+    Report("unsigned __int128 /", "-", "120 bit", NsPerOp(iterations, [&](std::size_t i) {
+        DoNotOptimize(lhs[i] / rhs[i]);
+    }));
+    Report("unsigned __int128 ==", "-", "120 bit", NsPerOp(iterations, [&](std::size_t i) {
+        DoNotOptimize(lhs[i] == rhs[(i + 1) % kOperands]);
+    }));
+#endif
+
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <lib/number.h>
 #include <gtest/gtest.h>
+#include <array>
 #include <bitset>
+#include <iomanip>
+#include <sstream>
 #include <cstring>
 #include <tuple>
 
@@ -137,8 +140,6 @@ TEST_P(OperationTestsSuite, SubstTest) {
 }
 
 
-// Раскомментироать для групп 00 - 09
-/*
 TEST_P(OperationTestsSuite, MultTest) {
     uint239_t a = FromString(std::get<0>(GetParam()).first, std::get<0>(GetParam()).second);
     uint239_t b = FromString(std::get<1>(GetParam()).first, std::get<1>(GetParam()).second);
@@ -161,7 +162,6 @@ TEST_P(OperationTestsSuite, DivTest) {
         ASSERT_EQ(result, expected);
     }
 }
-*/
 
 INSTANTIATE_TEST_SUITE_P(
     Group,
@@ -175,3 +175,246 @@ INSTANTIATE_TEST_SUITE_P(
         std::make_tuple(TValue{"1000", 1000}, TValue{"2", 999}, TValue{"1002", 1999}, TValue{"998", 1},  TValue{"2000", 1999}, TValue{"500", 1})
     )
 );
+
+
+TEST(ShiftTest, SubtractionWrapsShift) {
+    uint239_t a = FromInt(239, 3);
+    uint239_t b = FromInt(30, 5);
+
+    uint239_t result = a - b;
+
+    ASSERT_EQ(result, FromInt(209, 0));
+    ASSERT_EQ(GetShift(result), (1ull << 35) - 2);
+    ASSERT_EQ(GetShift(result + b), 3);
+}
+
+TEST(ShiftTest, RotationComposes) {
+    uint239_t a = FromString("777777777777777777", 0);
+
+    for (uint32_t step : {1u, 6u, 7u, 63u, 64u, 65u, 128u, 200u, 244u}) {
+        uint239_t rotated = ShiftNumber(ShiftNumber(a, step), 245 - step);
+        ASSERT_EQ(std::memcmp(rotated.data, a.data, sizeof(a.data)), 0) << step;
+        ASSERT_EQ(ShiftBack(ShiftFront(a, step), step), a) << step;
+    }
+}
+
+TEST(ShiftTest, OutOfRangeShiftWraps) {
+    // uint127_t stores 19 shift bits and uint239_t 35, so larger shifts wrap before the payload is rotated.
+    uint127_t small = FromInt<uint127_t>(5, (1u << 19) + 3);
+    uint127_t small_expected = FromInt<uint127_t>(5, 3);
+    ASSERT_EQ(std::memcmp(small.data, small_expected.data, sizeof(small.data)), 0);
+    ASSERT_EQ(FromInt<uint127_t>(5, 1u << 19), FromInt<uint127_t>(5, 0));
+    ASSERT_EQ(ToString(FromInt<uint127_t>(5, 1u << 19)), "5");
+
+    uint239_t front = ShiftFront(FromInt<uint239_t>(5, 0), (1ull << 35) + 1);
+    uint239_t expected = FromInt<uint239_t>(5, 1);
+    ASSERT_EQ(std::memcmp(front.data, expected.data, sizeof(front.data)), 0);
+    ASSERT_EQ(ToString(FromString<uint239_t>("5", 1ull << 35)), "5");
+    ASSERT_EQ(GetShift(FromString<uint239_t>("5", 1ull << 35)), 0);
+    ASSERT_EQ(ShiftBack(ShiftFront(FromInt<uint239_t>(5, 0), (1ull << 35) + 7), (1ull << 35) + 7), FromInt<uint239_t>(5, 0));
+}
+
+TEST(MulWideTest, FullProduct) {
+    uint239_t max = FromInt(0, 0) - FromInt(1, 0);
+
+    uint478_t square = MulWide(max, max);
+    ASSERT_EQ(square.high, max - FromInt(1, 0));
+    ASSERT_EQ(square.low, FromInt(1, 0));
+    ASSERT_EQ(max * max, square.low);
+
+    uint478_t small = MulWide(FromString("123456789123456789", 3), FromString("987654321987654321", 4));
+    ASSERT_EQ(small.high, FromInt(0, 7));
+    ASSERT_EQ(small.low, FromString("121932631356500531347203169112635269", 7));
+    ASSERT_EQ(GetShift(small.high), 7);
+}
+
+
+class DivModTestsSuite
+    : public testing::TestWithParam<
+        std::tuple<
+            TValue, // lhs
+            TValue, // rhs
+            TValue, // / result
+            TValue  // % result
+        >
+    >
+{
+};
+
+TEST_P(DivModTestsSuite, DivModTest) {
+    uint239_t a = FromString(std::get<0>(GetParam()).first, std::get<0>(GetParam()).second);
+    uint239_t b = FromString(std::get<1>(GetParam()).first, std::get<1>(GetParam()).second);
+    uint239_t quot = FromString(std::get<2>(GetParam()).first, std::get<2>(GetParam()).second);
+    uint239_t rem = FromString(std::get<3>(GetParam()).first, std::get<3>(GetParam()).second);
+
+    uint239_div_t result = DivMod(a, b);
+
+    ASSERT_EQ(result.quot, quot);
+    ASSERT_EQ(result.rem, rem);
+    ASSERT_EQ(a / b, quot);
+    ASSERT_EQ(a % b, rem);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    DivModTestsSuite,
+    testing::Values(
+        std::make_tuple(TValue{"1234567890123456789012345678901234567890123456789012345678", 5}, TValue{"7", 2}, TValue{"176366841446208112716049382700176366841446208112716049382", 3}, TValue{"4", 3}),
+        std::make_tuple(TValue{"1234567890123456789012345678901234567890123456789012345678", 0}, TValue{"18446744073709551557", 0}, TValue{"66926059427634869390730817480537497506", 0}, TValue{"5867476298746428836", 0}),
+        std::make_tuple(TValue{"1234567890123456789012345678901234567890123456789012345678", 40}, TValue{"42391158275216203514294433201", 30}, TValue{"29123240325453462550059120501", 10}, TValue{"16740544599910286686658191977", 10}),
+        std::make_tuple(TValue{"1234567890123456789012345678901234567890123456789012345678", 1}, TValue{"98765432109876543210987654321", 1}, TValue{"12499999886093750001423828124", 0}, TValue{"98242187499824218749982421874", 0}),
+        std::make_tuple(TValue{"42", 7}, TValue{"98765432109876543210987654321", 5}, TValue{"0", 2}, TValue{"42", 2})
+    )
+);
+
+
+class ToStringTestsSuite
+    : public testing::TestWithParam<TValue>
+{
+};
+
+TEST_P(ToStringTestsSuite, RoundTripTest) {
+    uint239_t value = FromString(GetParam().first, GetParam().second);
+
+    ASSERT_EQ(ToString(value), GetParam().first);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    ToStringTestsSuite,
+    testing::Values(
+        TValue{"0", 0},
+        TValue{"7", 3},
+        TValue{"2147483647", 8},
+        TValue{"9999999999999999999", 19},
+        TValue{"10000000000000000000", 20},
+        TValue{"100000000000000000000000000000000000001", 1000},
+        TValue{"1234567890123456789012345678901234567890123456789012345678", 77},
+        TValue{"883423532389192164791648750371459257913741948437809479060803100646309887", 239}
+    )
+);
+
+TEST(ToStringTest, StreamFormatting) {
+    std::ostringstream stream;
+    stream << std::setw(6) << std::setfill('*') << FromInt(239, 5) << '|' << std::left << std::setw(4) << FromInt(7, 1);
+
+    ASSERT_EQ(stream.str(), "***239|7***");
+    ASSERT_EQ(ToString(FromInt(0, 0) - FromInt(1, 0)), "883423532389192164791648750371459257913741948437809479060803100646309887");
+}
+
+
+TEST(FromCharsTest, ReportsErrors) {
+    uint239_t value = FromInt(5, 0);
+
+    const char* digits = "12345678901234567890123x";
+    std::from_chars_result result = FromChars(digits, digits + strlen(digits), value, 3);
+    ASSERT_EQ(result.ec, std::errc());
+    ASSERT_EQ(result.ptr, digits + 23);
+    ASSERT_EQ(value, FromString("12345678901234567890123", 3));
+
+    const char* letters = "x1";
+    result = FromChars(letters, letters + 2, value, 0);
+    ASSERT_EQ(result.ec, std::errc::invalid_argument);
+    ASSERT_EQ(result.ptr, letters);
+
+    const char* too_big = "883423532389192164791648750371459257913741948437809479060803100646309888";
+    result = FromChars(too_big, too_big + strlen(too_big), value, 0);
+    ASSERT_EQ(result.ec, std::errc::result_out_of_range);
+    ASSERT_EQ(result.ptr, too_big + strlen(too_big));
+    ASSERT_EQ(value, FromString("12345678901234567890123", 0));
+
+    ASSERT_THROW(FromString("12a4", 0), std::invalid_argument);
+    ASSERT_THROW(FromString("", 0), std::invalid_argument);
+    ASSERT_THROW(FromString(too_big, 0), std::out_of_range);
+    ASSERT_EQ(FromString("00000000000000000000000000000000000000042", 0), FromInt(42, 0));
+}
+
+
+// Evaluated by the compiler: a failure here breaks the build of the tests.
+static_assert(FromString("239", 1) == FromInt(239, 1));
+static_assert(GetShift(FromInt(239, 3) - FromInt(30, 5)) == (1ull << 35) - 2);
+static_assert(FromInt(239, 3) + FromInt(30, 5) == FromInt(269, 8));
+static_assert(FromInt(123, 6) * FromInt(10, 4) == FromInt(1230, 10));
+static_assert(FromInt(42, 7) / FromInt(5, 2) == FromInt(8, 5));
+static_assert(FromInt(42, 7) % FromInt(5, 2) == FromInt(2, 5));
+static_assert(FromString("1000000000000000000000000000000", 0) >= FromString("999999999999999999999999999999", 0));
+static_assert(MulWide(FromInt(0, 0) - FromInt(1, 0), FromInt(2, 0)).high == FromInt(1, 0));
+
+constexpr std::array<uint239_t, 72> kPowersOfTen = [] {
+    std::array<uint239_t, 72> powers{};
+    powers[0] = FromInt(1, 0);
+    for (std::size_t i = 1; i < powers.size(); ++i) {
+        powers[i] = powers[i - 1] * FromInt(10, 0);
+    }
+    return powers;
+}();
+
+static_assert(kPowersOfTen[71] == FromString("100000000000000000000000000000000000000000000000000000000000000000000000", 0));
+static_assert(kPowersOfTen[71] / kPowersOfTen[40] == kPowersOfTen[31]);
+
+TEST(ConstexprTest, PowersTable) {
+    for (std::size_t i = 0; i < kPowersOfTen.size(); ++i) {
+        ASSERT_EQ(ToString(kPowersOfTen[i]), "1" + std::string(i, '0'));
+    }
+}
+
+
+static_assert(sizeof(uint127_t) == 19);
+static_assert(sizeof(uint511_t) == 73);
+static_assert(FromString<uint127_t>("170141183460469231731687303715884105727", 5) + FromInt<uint127_t>(1, 0) == FromInt<uint127_t>(0, 5));
+
+TEST(WidthTest, Uint127) {
+    uint127_t a = FromString<uint127_t>("85070591730234615865843651857942065209", 11);
+    uint127_t b = FromString<uint127_t>("98765432109876543210", 3);
+
+    ASSERT_EQ(a * b, FromString<uint127_t>("1219259259396425925927450", 14));
+    ASSERT_EQ(a / b, FromString<uint127_t>("861339741171724764", 8));
+    ASSERT_EQ(a % b, FromString<uint127_t>("74940371796069012769", 8));
+    ASSERT_EQ(b - a, FromString<uint127_t>("85070591730234615964609083967818583729", 0));
+    ASSERT_EQ(ToString(a), "85070591730234615865843651857942065209");
+    ASSERT_EQ(GetShift(b - a), (1ull << 19) - 8);
+    ASSERT_THROW(FromString<uint127_t>("170141183460469231731687303715884105728", 0), std::out_of_range);
+}
+
+TEST(WidthTest, Uint511) {
+    const char* kMax = "6703903964971298549787012499102923063739682910296196688861780721860882015036773488400937149083451713845015929093243025426876941405973284973216824503042047";
+    uint511_t max = FromInt<uint511_t>(0, 0) - FromInt<uint511_t>(1, 0);
+
+    ASSERT_EQ(ToString(max), kMax);
+    ASSERT_EQ(FromString<uint511_t>(kMax, 600), max);
+
+    itmo_uint_wide<511> square = MulWide(max, max);
+    ASSERT_EQ(square.high, max - FromInt<uint511_t>(1, 0));
+    ASSERT_EQ(square.low, FromInt<uint511_t>(1, 0));
+    ASSERT_EQ(max / FromInt<uint511_t>(7, 0) * FromInt<uint511_t>(7, 0) + max % FromInt<uint511_t>(7, 0), max);
+
+    uint511_t wrapped = FromInt<uint511_t>(1, ~0ull) + FromInt<uint511_t>(1, 1);
+    ASSERT_EQ(GetShift(wrapped), 0);
+    ASSERT_EQ(wrapped, FromInt<uint511_t>(2, 0));
+    ASSERT_EQ(ShiftBack(ShiftFront(max, 1000), 1000), max);
+}
+
+
+static_assert(Encode(Decode(FromInt(239, 3)) - Decode(FromInt(30, 5))) == FromInt(209, 0));
+static_assert(Decode(FromInt(239, 3) - FromInt(30, 5)).shift == (1ull << 35) - 2);
+
+TEST(ValueTest, ChainMatchesEncodedOperators) {
+    uint239_t a = FromString("123456789012345678901234567890", 17);
+    uint239_t b = FromString("987654321", 1000);
+    uint239_t c = FromString("55555555555555555555555555555555555555555555555555", 3);
+
+    uint239_t encoded = a;
+    uint239_value_t value = Decode(a);
+    for (int i = 0; i < 20; i++) {
+        encoded = (encoded * b + c) % (c - b) - b / FromInt(7, 2);
+        value = (value * Decode(b) + Decode(c)) % (Decode(c) - Decode(b)) - Decode(b) / Decode(FromInt(7, 2));
+    }
+
+    uint239_t result = Encode(value);
+    ASSERT_EQ(result, encoded);
+    ASSERT_EQ(GetShift(result), GetShift(encoded));
+    ASSERT_EQ(value.shift, GetShift(encoded));
+    ASSERT_EQ(std::memcmp(result.data, encoded.data, sizeof(result.data)), 0);
+    ASSERT_TRUE(Decode(c) >= Decode(b));
+    ASSERT_NE(Decode(b), Decode(c));
+}
@@ -0,0 +1,103 @@
+#include <lib/uint239_vector.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+
+namespace {
+
+uint239_t RandomValue(std::mt19937_64& random) {
+    std::string digits = std::to_string(random() % 9 + 1);
+    int length = random() % 71;
+    for (int i = 0; i < length; i++) {
+        digits += static_cast<char>('0' + random() % 10);
+    }
+    return FromString(digits.c_str(), random() % 1000);
+}
+
+} // namespace
+
+
+class VectorTestsSuite : public testing::TestWithParam<std::size_t> {
+protected:
+    void SetUp() override {
+        std::mt19937_64 random(GetParam());
+        for (std::size_t i = 0; i < GetParam(); i++) {
+            lhs.push_back(RandomValue(random));
+            // Every third pair is equal so that ties and zero differences are covered.
+            rhs.push_back(i % 3 == 0 ? lhs[i] : RandomValue(random));
+        }
+    }
+
+    uint239_vector lhs;
+    uint239_vector rhs;
+};
+
+TEST_P(VectorTestsSuite, ElementWiseTest) {
+    uint239_vector sum = lhs + rhs;
+    uint239_vector diff = lhs - rhs;
+    std::vector<int8_t> order = Compare(lhs, rhs);
+
+    for (std::size_t i = 0; i < lhs.size(); i++) {
+        ASSERT_EQ(sum[i], lhs[i] + rhs[i]) << i;
+        ASSERT_EQ(GetShift(sum[i]), GetShift(lhs[i] + rhs[i])) << i;
+        ASSERT_EQ(diff[i], lhs[i] - rhs[i]) << i;
+        ASSERT_EQ(GetShift(diff[i]), GetShift(lhs[i] - rhs[i])) << i;
+        int expected = lhs[i] == rhs[i] ? 0 : (lhs[i] >= rhs[i] ? 1 : -1);
+        ASSERT_EQ(order[i], expected) << i;
+    }
+}
+
+TEST_P(VectorTestsSuite, ReductionTest) {
+    uint239_t sum = FromInt(0, 0);
+    for (std::size_t i = 0; i < lhs.size(); i++) {
+        sum = sum + lhs[i];
+    }
+    ASSERT_EQ(Sum(lhs), sum);
+    ASSERT_EQ(GetShift(Sum(lhs)), GetShift(sum));
+
+    if (lhs.size() == 0) {
+        ASSERT_THROW(Min(lhs), std::out_of_range);
+        return;
+    }
+    std::size_t min = 0;
+    std::size_t max = 0;
+    for (std::size_t i = 1; i < lhs.size(); i++) {
+        if (!(lhs[i] >= lhs[min])) {
+            min = i;
+        }
+        if (!(lhs[max] >= lhs[i])) {
+            max = i;
+        }
+    }
+    ASSERT_EQ(Min(lhs), lhs[min]);
+    ASSERT_EQ(GetShift(Min(lhs)), GetShift(lhs[min]));
+    ASSERT_EQ(Max(lhs), lhs[max]);
+    ASSERT_EQ(GetShift(Max(lhs)), GetShift(lhs[max]));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Group,
+    VectorTestsSuite,
+    testing::Values(0, 1, 3, 4, 7, 64, 1001)
+);
+
+TEST(VectorTest, LayoutAndErrors) {
+    uint239_vector values(5);
+    values.set(2, FromInt(239, 7));
+
+    ASSERT_EQ(values[2], FromInt(239, 7));
+    ASSERT_EQ(GetShift(values[2]), 7);
+    ASSERT_EQ(values[0], FromInt(0, 0));
+    for (int k = 0; k < uint239_vector::kLimbCount; k++) {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(values.limbs(k)) % 64, 0);
+    }
+    ASSERT_THROW(values + uint239_vector(4), std::invalid_argument);
+
+    uint239_vector repeated;
+    for (int i = 0; i < 9; i++) {
+        repeated.push_back(FromInt(5, i));
+    }
+    ASSERT_EQ(GetShift(Min(repeated)), 0);
+    ASSERT_EQ(GetShift(Max(repeated)), 0);
+}